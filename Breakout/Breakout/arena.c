@@ -0,0 +1,42 @@
+// the level arena
+
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+size_t arenaRound(size_t size) {
+	return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+void arenaReserve(arena* a, size_t size) {
+	size = arenaRound(size);
+	if (size > a->size) { //the old contents are dropped anyway, so a new block is better than realloc copying them
+		free(a->block);
+		a->block = malloc(size + ARENA_ALIGN);
+		a->memory = (unsigned char*)(((uintptr_t)a->block + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1));
+		a->size = a->block != NULL ? size : 0;
+	}
+	a->used = 0;
+}
+
+void* arenaAlloc(arena* a, size_t size) {
+	size = arenaRound(size);
+	if (size > a->size - a->used) return NULL;
+	void* p = a->memory + a->used;
+	a->used += size;
+	return p;
+}
+
+size_t arenaMark(const arena* a) {
+	return a->used;
+}
+
+void arenaRewind(arena* a, size_t mark) {
+	if (mark <= a->used) a->used = mark;
+}
+
+void arenaFree(arena* a) {
+	free(a->block);
+	memset(a, 0, sizeof(*a));
+}
@@ -0,0 +1,26 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+// a block of memory handed out front to back and emptied all at once: everything a level needs comes from one,
+// so starting the next level frees the last one in O(1) and playing never calls malloc
+
+#include <stddef.h>
+
+#define ARENA_ALIGN 64 //every allocation starts on its own cache line
+
+typedef struct arena
+{
+	void* block; //what malloc returned
+	unsigned char* memory; //block aligned to ARENA_ALIGN
+	size_t size;
+	size_t used;
+} arena;
+
+size_t arenaRound(size_t size); // what an allocation of size bytes takes from the arena
+void arenaReserve(arena* a, size_t size); // empties the arena and makes room for size bytes, nothing taken from it before is valid after this
+void* arenaAlloc(arena* a, size_t size); // NULL if it does not fit
+size_t arenaMark(const arena* a);
+void arenaRewind(arena* a, size_t mark); // gives back everything taken since arenaMark, for scratch memory
+void arenaFree(arena* a);
+
+#endif
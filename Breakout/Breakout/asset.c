@@ -0,0 +1,345 @@
+// the picture loader, see asset.h
+
+#include "asset.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "profile.h"
+#ifdef _WIN32
+#include <direct.h>
+#define makeDirectory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define makeDirectory(path) mkdir(path, 0755)
+#endif
+
+/* only in the headers of GL 1.4 and newer, Windows has the ones of 1.1 */
+#ifndef GL_GENERATE_MIPMAP
+#define GL_GENERATE_MIPMAP 0x8191
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+
+static const char cacheMagic[4] = { 'B', 'K', 'T', 'X' };
+#define CACHE_VERSION 1
+
+static unsigned char* readFile(const char* path, size_t* size) {
+	FILE* f = fopen(path, "rb");
+	if (f == NULL) return NULL;
+	fseek(f, 0, SEEK_END);
+	long length = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	unsigned char* data = length > 0 ? malloc(length) : NULL;
+	if (data != NULL && fread(data, 1, length, f) != (size_t)length) {
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+	*size = data != NULL ? (size_t)length : 0;
+	return data;
+}
+
+static unsigned long long hashBytes(const unsigned char* data, size_t size) { //FNV-1a, 64 bits
+	unsigned long long h = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++) {
+		h ^= data[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static unsigned int readU16(const unsigned char* p) { return p[0] | p[1] << 8; }
+static unsigned int readU32(const unsigned char* p) { return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24; }
+
+static void writeU32(unsigned char* p, unsigned int v) {
+	for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static int maskShift(unsigned int mask) { //where an 8 bit channel mask starts, -1 for no mask
+	if (mask == 0) return -1;
+	int shift = 0;
+	while (!(mask & 1u)) {
+		mask >>= 1;
+		shift++;
+	}
+	return shift;
+}
+
+/* BMP: a 14 byte file header, an info header of 40 bytes or more (the later versions only add to it), the palette or the
+   channel masks, and the rows, bottom row first unless the height is negative, every row padded to 4 bytes */
+bool assetDecodeBmp(const unsigned char* data, size_t size, int* width, int* height, unsigned char** pixels) {
+	if (size < 54 || data[0] != 'B' || data[1] != 'M') return false;
+	unsigned int offset = readU32(data + 10), infoSize = readU32(data + 14);
+	int w = (int)readU32(data + 18), h = (int)readU32(data + 22);
+	unsigned int bits = readU16(data + 28), compression = readU32(data + 30), colours = readU32(data + 46);
+	bool topDown = h < 0;
+	if (topDown) h = -h;
+	if (infoSize < 40 || w <= 0 || h <= 0 || w > 16384 || h > 16384 || readU16(data + 26) != 1) return false;
+	if (!(bits == 8 || bits == 24 || bits == 32) || !(compression == 0 || (compression == 3 && bits == 32))) return false;
+	size_t pitch = ((size_t)w * bits + 31) / 32 * 4;
+	if (offset > size || pitch * h > size - offset) return false;
+
+	unsigned int masks[4] = { 0x00ff0000u, 0x0000ff00u, 0x000000ffu, 0 }; //red, green, blue, alpha: the BI_RGB layout, no alpha
+	if (compression == 3) { //BI_BITFIELDS: the masks are in the info header from version 4 on, after a version 1 header otherwise
+		if (14 + 40 + 12 > size) return false;
+		for (int c = 0; c < 3; c++) masks[c] = readU32(data + 54 + 4 * c);
+		if (infoSize >= 56 && 14 + 56 <= size) masks[3] = readU32(data + 54 + 12);
+	}
+	int shifts[4];
+	for (int c = 0; c < 4; c++) shifts[c] = maskShift(masks[c]);
+	const unsigned char* palette = data + 14 + infoSize;
+	if (colours == 0 || colours > 256) colours = 256;
+	if (bits == 8 && (size_t)(palette - data) + colours * 4 > size) return false;
+
+	unsigned char* out = malloc((size_t)w * h * 4);
+	if (out == NULL) return false;
+	for (int y = 0; y < h; y++) {
+		const unsigned char* row = data + offset + pitch * (topDown ? y : h - 1 - y);
+		unsigned char* o = out + (size_t)y * w * 4;
+		for (int x = 0; x < w; x++, o += 4) {
+			if (bits == 24) { //blue, green, red
+				o[0] = row[x * 3 + 2];
+				o[1] = row[x * 3 + 1];
+				o[2] = row[x * 3];
+				o[3] = 255;
+			}
+			else if (bits == 32) {
+				unsigned int v = readU32(row + x * 4);
+				for (int c = 0; c < 4; c++) o[c] = shifts[c] < 0 ? 255 : (unsigned char)((v & masks[c]) >> shifts[c]);
+			}
+			else {
+				unsigned int index = row[x] < colours ? row[x] : 0;
+				o[0] = palette[index * 4 + 2];
+				o[1] = palette[index * 4 + 1];
+				o[2] = palette[index * 4];
+				o[3] = 255;
+			}
+		}
+	}
+	*width = w;
+	*height = h;
+	*pixels = out;
+	return true;
+}
+
+/* run length coding of whole pixels, the menu pictures are mostly flat colour. A control byte below 128 is followed by
+   that many plus one pixels as they are, one of 128 or more by a single pixel repeated control - 126 times */
+static size_t compressPixels(const unsigned int* in, size_t count, unsigned char* out) { //out needs count * 4 + count / 128 + 1 bytes
+	size_t o = 0, i = 0;
+	while (i < count) {
+		size_t run = 1;
+		while (i + run < count && run < 129 && in[i + run] == in[i]) run++;
+		if (run >= 2) {
+			out[o++] = (unsigned char)(run + 126);
+			memcpy(out + o, &in[i], 4);
+			o += 4;
+			i += run;
+			continue;
+		}
+		size_t literal = 1; //up to the next run of 2
+		while (i + literal < count && literal < 128 && !(i + literal + 1 < count && in[i + literal] == in[i + literal + 1])) literal++;
+		out[o++] = (unsigned char)(literal - 1);
+		memcpy(out + o, &in[i], literal * 4);
+		o += literal * 4;
+		i += literal;
+	}
+	return o;
+}
+
+static bool expandPixels(const unsigned char* in, size_t size, unsigned int* out, size_t count) {
+	size_t i = 0, o = 0;
+	while (o < count) {
+		if (i >= size) return false;
+		unsigned int control = in[i++];
+		size_t n = control < 128 ? control + 1 : control - 126;
+		if (o + n > count || i + (control < 128 ? n * 4 : 4) > size) return false;
+		if (control < 128) {
+			memcpy(out + o, in + i, n * 4);
+			i += n * 4;
+		}
+		else {
+			unsigned int pixel;
+			memcpy(&pixel, in + i, 4);
+			i += 4;
+			for (size_t k = 0; k < n; k++) out[o + k] = pixel;
+		}
+		o += n;
+	}
+	return true;
+}
+
+static void cachePath(unsigned long long hash, char* out, size_t size) { //cache/<hash of the BMP>.tex, so pictures with the same name do not share one
+	snprintf(out, size, "%s/%016llx.tex", ASSET_CACHE_DIR, hash);
+}
+
+/* the cache file: magic, version, hash of the BMP, width, height, size of the compressed pixels, and the pixels */
+static bool readCache(textureAsset* a, unsigned long long hash) {
+	char path[64];
+	size_t size;
+	cachePath(hash, path, sizeof(path));
+	unsigned char* data = readFile(path, &size);
+	if (data == NULL) return false;
+	bool ok = size >= 28 && memcmp(data, cacheMagic, 4) == 0 && readU32(data + 4) == CACHE_VERSION
+		&& ((unsigned long long)readU32(data + 8) | (unsigned long long)readU32(data + 12) << 32) == hash;
+	int w = ok ? (int)readU32(data + 16) : 0, h = ok ? (int)readU32(data + 20) : 0;
+	size_t packed = ok ? readU32(data + 24) : 0;
+	ok = ok && w > 0 && h > 0 && w <= 16384 && h <= 16384 && packed <= size - 28;
+	if (ok) {
+		a->pixels = malloc((size_t)w * h * 4);
+		ok = a->pixels != NULL && expandPixels(data + 28, packed, (unsigned int*)a->pixels, (size_t)w * h);
+		if (!ok) {
+			free(a->pixels);
+			a->pixels = NULL;
+		}
+	}
+	free(data);
+	a->width = w;
+	a->height = h;
+	return ok;
+}
+
+static void writeCache(const textureAsset* a, unsigned long long hash) { //nothing happens if it cannot be written, the next start decodes again
+	size_t count = (size_t)a->width * a->height;
+	unsigned char* data = malloc(28 + count * 4 + count / 128 + 1);
+	if (data == NULL) return;
+	memcpy(data, cacheMagic, 4);
+	writeU32(data + 4, CACHE_VERSION);
+	writeU32(data + 8, (unsigned int)hash);
+	writeU32(data + 12, (unsigned int)(hash >> 32));
+	writeU32(data + 16, (unsigned int)a->width);
+	writeU32(data + 20, (unsigned int)a->height);
+	size_t packed = compressPixels((const unsigned int*)a->pixels, count, data + 28);
+	writeU32(data + 24, (unsigned int)packed);
+	char path[64];
+	cachePath(hash, path, sizeof(path));
+	makeDirectory(ASSET_CACHE_DIR);
+	FILE* f = fopen(path, "wb");
+	if (f != NULL) {
+		fwrite(data, 1, 28 + packed, f);
+		fclose(f);
+	}
+	free(data);
+}
+
+static int assetWorker(void* data) {
+	assetLoader* l = data;
+	for (int i = 0; i < l->count; i++) {
+		textureAsset* a = &l->assets[i];
+		unsigned long long start = profileNow(); //monotonic, the wall clock can jump while loading
+		size_t size;
+		unsigned char* file = readFile(a->path, &size);
+		bool ok = false;
+		if (file != NULL) {
+			unsigned long long hash = hashBytes(file, size); //the cache is only used for exactly the same BMP
+			a->fromCache = readCache(a, hash);
+			ok = a->fromCache || assetDecodeBmp(file, size, &a->width, &a->height, &a->pixels);
+			if (ok && !a->fromCache) writeCache(a, hash);
+			free(file);
+		}
+		a->loadTime = (profileNow() - start) / 1e9;
+		if (!ok) printf("cannot load the picture %s\n", a->path);
+		atomicStore(&a->state, ok ? ASSET_DECODED : ASSET_FAILED);
+	}
+	return 0;
+}
+
+static void glVersion(int* major, int* minor) {
+	const char* version = (const char*)glGetString(GL_VERSION);
+	*major = *minor = 0;
+	if (version != NULL) sscanf(version, "%d.%d", major, minor);
+}
+
+void assetInit(assetLoader* l, assetProcLoader getProc) {
+	memset(l, 0, sizeof(*l));
+	int major, minor;
+	glVersion(&major, &minor);
+	const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+	l->useMipmaps = major > 1 || minor >= 4;
+	if (getProc != NULL && (major > 2 || (major == 2 && minor >= 1) || (extensions != NULL && strstr(extensions, "GL_ARB_pixel_buffer_object") != NULL))) {
+		*(void**)&l->genBuffers = getProc("glGenBuffers");
+		*(void**)&l->bindBuffer = getProc("glBindBuffer");
+		*(void**)&l->bufferData = getProc("glBufferData");
+		*(void**)&l->mapBuffer = getProc("glMapBuffer");
+		*(void**)&l->unmapBuffer = getProc("glUnmapBuffer");
+		*(void**)&l->deleteBuffers = getProc("glDeleteBuffers");
+		l->usePixelBuffer = l->genBuffers && l->bindBuffer && l->bufferData && l->mapBuffer && l->unmapBuffer && l->deleteBuffers;
+		if (l->usePixelBuffer) l->genBuffers(1, &l->pixelBuffer);
+	}
+}
+
+int assetRequest(assetLoader* l, const char* path) {
+	if (l->count == ASSET_MAX || l->running) return -1;
+	textureAsset* a = &l->assets[l->count];
+	snprintf(a->path, sizeof(a->path), "%s", path);
+	a->state = ASSET_QUEUED;
+	return l->count++;
+}
+
+void assetStart(assetLoader* l) {
+	l->running = threadCreate(&l->worker, assetWorker, l);
+	if (!l->running) assetWorker(l); //no thread, the start is slower but it works
+}
+
+static void upload(assetLoader* l, textureAsset* a) {
+	size_t size = (size_t)a->width * a->height * 4;
+	const void* source = a->pixels;
+	glGenTextures(1, &a->texture);
+	glBindTexture(GL_TEXTURE_2D, a->texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, l->useMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	if (l->useMipmaps) glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	if (l->usePixelBuffer) { //the driver copies from its own buffer when it suits it, glTexImage2D does not wait for it
+		l->bindBuffer(GL_PIXEL_UNPACK_BUFFER, l->pixelBuffer);
+		l->bufferData(GL_PIXEL_UNPACK_BUFFER, (ptrdiff_t)size, NULL, GL_STREAM_DRAW);
+		void* staging = l->mapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+		if (staging != NULL) {
+			memcpy(staging, a->pixels, size);
+			l->unmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			source = NULL; //from the start of the buffer
+		}
+		else l->bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, a->width, a->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, source);
+	if (source == NULL) l->bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	free(a->pixels);
+	a->pixels = NULL;
+	atomicStore(&a->state, ASSET_READY);
+}
+
+void assetUpdate(assetLoader* l) {
+	for (int i = 0; i < l->count; i++) {
+		textureAsset* a = &l->assets[i];
+		if (atomicLoad(&a->state) == ASSET_DECODED) {
+			upload(l, a);
+			return; //one per frame, so a frame never waits for more than one
+		}
+	}
+}
+
+GLuint assetTexture(const assetLoader* l, int handle) {
+	if (handle < 0 || handle >= l->count) return 0;
+	return l->assets[handle].texture;
+}
+
+void assetFree(assetLoader* l) {
+	if (l->running) threadJoin(l->worker);
+	l->running = false;
+	for (int i = 0; i < l->count; i++) {
+		textureAsset* a = &l->assets[i];
+		if (a->texture != 0) glDeleteTextures(1, &a->texture);
+		free(a->pixels);
+		a->pixels = NULL;
+		a->texture = 0;
+	}
+	if (l->usePixelBuffer) l->deleteBuffers(1, &l->pixelBuffer);
+	l->count = 0;
+}
@@ -0,0 +1,73 @@
+#ifndef ASSET_H
+#define ASSET_H
+
+// the pictures of the menu and the result screens. A worker thread decodes the BMPs (any size, 8, 24 or 32 bits, with their
+// real row pitch) into RGBA, and the main thread uploads them when they are ready: one per frame, through a pixel buffer
+// when the driver has them, with mipmaps, and then the decoded copy is freed.
+// Every decoded picture is also saved in ASSET_CACHE_DIR, already in the layout OpenGL takes and run length compressed,
+// in a file named after a hash of the BMP it came from (the hash is checked again inside): the next start finds it there
+// and does not decode anything
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "thread.h"
+
+#define ASSET_MAX 16
+#define ASSET_PATH_MAX 256
+#define ASSET_CACHE_DIR "cache"
+
+typedef enum assetState
+{
+	ASSET_QUEUED,
+	ASSET_DECODED, //the pixels are ready for the main thread to upload
+	ASSET_READY, //uploaded, the pixels are gone
+	ASSET_FAILED
+} assetState;
+
+typedef struct textureAsset
+{
+	char path[ASSET_PATH_MAX];
+	volatile int state; //an assetState, written by the worker while it is decoding
+	int width;
+	int height;
+	unsigned char* pixels; //RGBA, top row first
+	bool fromCache; //the cache had it, nothing was decoded
+	double loadTime; //seconds the worker spent on it
+	GLuint texture;
+} textureAsset;
+
+typedef void* (*assetProcLoader)(const char* name); // SDL_GL_GetProcAddress, for the pixel buffer functions
+
+typedef struct assetLoader
+{
+	textureAsset assets[ASSET_MAX];
+	int count;
+	thread worker;
+	bool running;
+	bool usePixelBuffer; //GL 2.1 or ARB_pixel_buffer_object, and the functions could be found
+	bool useMipmaps; //GL 1.4, the driver builds them
+	void (APIENTRY *genBuffers)(GLsizei n, GLuint* buffers);
+	void (APIENTRY *bindBuffer)(GLenum target, GLuint buffer);
+	void (APIENTRY *bufferData)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+	void* (APIENTRY *mapBuffer)(GLenum target, GLenum access);
+	GLboolean (APIENTRY *unmapBuffer)(GLenum target);
+	void (APIENTRY *deleteBuffers)(GLsizei n, const GLuint* buffers);
+	GLuint pixelBuffer;
+} assetLoader;
+
+/* once there is a GL context: request every picture, then assetStart decodes them in the background */
+void assetInit(assetLoader* l, assetProcLoader getProc);
+int assetRequest(assetLoader* l, const char* path); // the handle of the picture, -1 if there are too many
+void assetStart(assetLoader* l);
+void assetUpdate(assetLoader* l); // call it every frame on the GL thread, uploads the next decoded picture
+GLuint assetTexture(const assetLoader* l, int handle); // 0 until it is uploaded (or if it failed)
+void assetFree(assetLoader* l); // waits for the worker and deletes the textures
+
+/* the decoding, also used without GL. pixels is RGBA, top row first, free it with free() */
+bool assetDecodeBmp(const unsigned char* data, size_t size, int* width, int* height, unsigned char** pixels);
+
+#endif
@@ -0,0 +1,229 @@
+// the mixer, see audio.h
+
+#include "audio.h"
+#include "simd.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "thread.h"
+
+#define QUEUE_MASK (AUDIO_QUEUE_SIZE - 1)
+
+static const double soundSeconds[SOUND_TYPES] = { 0.06, 0.04, 0.15, 0.3, 0.6 }; //paddle, hit, break, powerup, life lost
+
+static double soundAt(soundType type, double t, unsigned int* noise) { //the sounds are made up, there are no sound files
+	double length = soundSeconds[type], left = 1.0 - t / length;
+	switch (type) {
+	case SOUND_PADDLE: //a short low blip
+		return sin(2.0 * PI * 520.0 * t) * exp(-t * 60.0);
+	case SOUND_HIT: //a higher click, a bit square
+		return (sin(2.0 * PI * 880.0 * t) > 0.0 ? 0.6 : -0.6) * exp(-t * 90.0);
+	case SOUND_BREAK: { //a crack: noise over a falling tone
+		*noise = *noise * 1664525u + 1013904223u;
+		double crack = ((*noise >> 9) / 4194304.0 - 1.0) * exp(-t * 40.0);
+		return 0.5 * crack + 0.5 * sin(2.0 * PI * (300.0 - 600.0 * t) * t) * left;
+	}
+	case SOUND_POWERUP: { //three notes going up
+		static const double notes[3] = { 660.0, 880.0, 1320.0 };
+		int note = (int)(t / 0.1) < 3 ? (int)(t / 0.1) : 2;
+		double inNote = t - note * 0.1;
+		return sin(2.0 * PI * notes[note] * t) * exp(-inNote * 20.0);
+	}
+	case SOUND_LIFE_LOST: //a long slide down
+		return sin(2.0 * PI * (440.0 - 275.0 * t / length) * t) * left;
+	default:
+		return 0.0;
+	}
+}
+
+static bool synthesize(audioMixer* m) {
+	unsigned int noise = 12345u;
+	for (int s = 0; s < SOUND_TYPES; s++) {
+		int length = (int)(soundSeconds[s] * AUDIO_RATE);
+		Sint16* samples = malloc(length * sizeof(Sint16));
+		if (samples == NULL) return false;
+		for (int i = 0; i < length; i++) {
+			double v = soundAt((soundType)s, (double)i / AUDIO_RATE, &noise);
+			double fade = i < 48 ? i / 48.0 : 1.0; //no click at the start
+			samples[i] = (Sint16)(fmax(-1.0, fmin(1.0, v * fade)) * 32767.0);
+		}
+		m->sounds[s] = samples;
+		m->soundLength[s] = length;
+	}
+	return true;
+}
+
+/* out += in * volume / 32768, saturated */
+#ifdef SIMD_X86
+TARGET_SSE2 static void mixVoice(Sint16* out, const Sint16* in, int count, int volume) {
+	__m128i gain = _mm_set1_epi16((short)volume);
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i scaled = _mm_slli_epi16(_mm_mulhi_epi16(_mm_loadu_si128((const __m128i*)(in + i)), gain), 1); //the high half is / 65536
+		_mm_storeu_si128((__m128i*)(out + i), _mm_adds_epi16(_mm_loadu_si128((const __m128i*)(out + i)), scaled));
+	}
+	for (; i < count; i++) {
+		int v = out[i] + ((in[i] * volume) >> 16) * 2;
+		out[i] = (Sint16)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+	}
+}
+#else
+static void mixVoice(Sint16* out, const Sint16* in, int count, int volume) {
+	for (int i = 0; i < count; i++) {
+		int v = out[i] + ((in[i] * volume) >> 16) * 2;
+		out[i] = (Sint16)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+	}
+}
+#endif
+
+static void startVoice(audioMixer* m, const soundRequest* r) {
+	audioVoice* v = NULL;
+	int left = 0x7fffffff;
+	for (int i = 0; i < AUDIO_VOICES; i++) { //a free voice, or the one closest to its end
+		audioVoice* c = &m->voices[i];
+		if (c->samples == NULL) {
+			v = c;
+			break;
+		}
+		if (c->length - c->position < left) {
+			left = c->length - c->position;
+			v = c;
+		}
+	}
+	if (v->samples != NULL) atomicStore(&m->stolen, m->stolen + 1);
+	v->samples = m->sounds[r->sound];
+	v->length = m->soundLength[r->sound];
+	v->position = 0;
+	v->volume = r->volume;
+}
+
+static void SDLCALL audioCallback(void* data, Uint8* stream, int bytes) { //on SDL's audio thread: no locks, no allocations, no waiting
+	audioMixer* m = data;
+	Uint64 start = SDL_GetPerformanceCounter();
+	int read = m->requestsRead, written = atomicLoad(&m->requestsWritten);
+	int bufferMicros = (int)(1000000LL * m->bufferSamples / AUDIO_RATE);
+	for (; read != written; read++) {
+		const soundRequest* r = &m->requests[read & QUEUE_MASK];
+		startVoice(m, r);
+		int latency = (int)((start - r->time) * 1000000 / m->frequency) + bufferMicros;
+		int sent = m->latenciesWritten;
+		if ((unsigned int)(sent - atomicLoad(&m->latenciesRead)) < AUDIO_QUEUE_SIZE) { //the main thread reads them at least once a second, a full ring only loses statistics
+			m->latencies[sent & QUEUE_MASK] = latency;
+			atomicStore(&m->latenciesWritten, sent + 1);
+		}
+	}
+	atomicStore(&m->requestsRead, read);
+
+	Sint16* out = (Sint16*)stream;
+	int count = bytes / (int)sizeof(Sint16);
+	memset(stream, 0, bytes);
+	for (int i = 0; i < AUDIO_VOICES; i++) {
+		audioVoice* v = &m->voices[i];
+		if (v->samples == NULL) continue;
+		int n = v->length - v->position < count ? v->length - v->position : count;
+		mixVoice(out, v->samples + v->position, n, v->volume);
+		v->position += n;
+		if (v->position == v->length) v->samples = NULL;
+	}
+	atomicStore(&m->callbacks, m->callbacks + 1);
+	atomicStore64(&m->mixTime, m->mixTime + (long long)((SDL_GetPerformanceCounter() - start) * 1000000000 / m->frequency));
+}
+
+bool audioOpen(audioMixer* m) {
+	memset(m, 0, sizeof(*m));
+	m->frequency = SDL_GetPerformanceFrequency();
+	if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+		printf("No sound: %s\n", SDL_GetError());
+		return false;
+	}
+	if (!synthesize(m)) {
+		audioClose(m);
+		return false;
+	}
+	SDL_AudioSpec want, have;
+	memset(&want, 0, sizeof(want));
+	want.freq = AUDIO_RATE;
+	want.format = AUDIO_S16SYS;
+	want.channels = 1;
+	want.samples = AUDIO_BUFFER;
+	want.callback = audioCallback;
+	want.userdata = m;
+	m->device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0); //no changes allowed, SDL converts to what the device wants
+	if (m->device == 0) {
+		printf("No sound: %s\n", SDL_GetError());
+		audioClose(m);
+		return false;
+	}
+	m->bufferSamples = have.samples;
+	SDL_PauseAudioDevice(m->device, 0);
+	return true;
+}
+
+void audioClose(audioMixer* m) {
+	if (m->device != 0) SDL_CloseAudioDevice(m->device); //waits for the callback to finish
+	m->device = 0;
+	for (int s = 0; s < SOUND_TYPES; s++) {
+		free(m->sounds[s]);
+		m->sounds[s] = NULL;
+	}
+	SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+void audioPlay(audioMixer* m, soundType sound, int volume) {
+	if (m->device == 0) return;
+	int written = m->requestsWritten;
+	if ((unsigned int)(written - atomicLoad(&m->requestsRead)) >= AUDIO_QUEUE_SIZE) {
+		m->dropped++;
+		return;
+	}
+	soundRequest* r = &m->requests[written & QUEUE_MASK];
+	r->sound = sound;
+	r->volume = volume;
+	r->time = SDL_GetPerformanceCounter();
+	atomicStore(&m->requestsWritten, written + 1); //the request is complete before the callback can see it
+	m->played++;
+}
+
+void audioPlayEvents(audioMixer* m, const gameEvent* events, int count) {
+	static const soundType sounds[] = { SOUND_BREAK, SOUND_PADDLE, SOUND_POWERUP, SOUND_HIT, SOUND_LIFE_LOST }; //by gameEventType
+	static const int volumes[SOUND_TYPES] = { 9000, 7000, 10000, 12000, 14000 }; //a few at once still fit without clipping
+	bool played[SOUND_TYPES] = { false };
+	for (int i = 0; i < count; i++) { //one of every sound per frame: with many balls the same sound 100 times at once is only noise
+		soundType s = sounds[events[i].type];
+		if (played[s]) continue;
+		played[s] = true;
+		audioPlay(m, s, volumes[s]);
+	}
+}
+
+void audioCollect(audioMixer* m) {
+	int read = m->latenciesRead, written = atomicLoad(&m->latenciesWritten);
+	for (; read != written; read++) {
+		int latency = m->latencies[read & QUEUE_MASK];
+		m->reportSum += latency;
+		m->totalLatency += latency;
+		if (latency > m->reportWorst) m->reportWorst = latency;
+		if (latency > m->totalWorst) m->totalWorst = latency;
+		m->reportSamples++;
+		m->totalSamples++;
+	}
+	atomicStore(&m->latenciesRead, read);
+}
+
+bool audioReport(audioMixer* m, char* text, int size) {
+	audioCollect(m);
+	if (m->reportSamples == 0) return false;
+	snprintf(text, size, "sound %.1f ms after the hit (worst %.1f ms)", m->reportSum / m->reportSamples / 1000.0, m->reportWorst / 1000.0);
+	m->reportSum = 0.0;
+	m->reportWorst = m->reportSamples = 0;
+	return true;
+}
+
+void audioSummary(audioMixer* m, FILE* out) {
+	audioCollect(m);
+	if (m->device == 0 || m->played == 0) return;
+	int callbacks = atomicLoad(&m->callbacks);
+	fprintf(out, "%d sounds played on average %.2f ms after they were triggered (worst %.2f ms), %d dropped, %d cut short, mixing took %.1f us per callback\n",
+		m->played, m->totalSamples > 0 ? m->totalLatency / m->totalSamples / 1000.0 : 0.0, m->totalWorst / 1000.0, m->dropped, atomicLoad(&m->stolen),
+		callbacks > 0 ? atomicLoad64(&m->mixTime) / 1000.0 / callbacks : 0.0);
+}
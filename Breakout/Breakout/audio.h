@@ -0,0 +1,86 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+// the sounds of the game. The main thread turns the events of the game into sound requests in a lock-free ring with one
+// writer and one reader, and SDL's audio callback takes them from there and mixes the voices. Every sound is synthesized
+// into memory when the mixer opens, so the callback never decodes, allocates or locks anything: it reads the ring, adds
+// the playing voices 8 samples at a time with saturating SSE2 adds, and hands the latency of every sound it starts back
+// through a second ring the main thread reads.
+// The latency is from the trigger to the callback that starts the sound, plus one buffer for the device to play it.
+// SDL_AUDIODRIVER=dummy runs it without a sound card, and disk also writes the output to SDL_DISKAUDIOFILE
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "game.h"
+
+#define AUDIO_RATE 48000
+#define AUDIO_BUFFER 512 // samples per callback, 10.7 ms
+#define AUDIO_VOICES 32 // sounds playing at the same time, a new one takes the place of the one closest to its end
+#define AUDIO_QUEUE_SIZE 256 // both rings, a power of two
+
+typedef enum soundType
+{
+	SOUND_PADDLE,
+	SOUND_HIT, //a block that does not break
+	SOUND_BREAK,
+	SOUND_POWERUP,
+	SOUND_LIFE_LOST,
+	SOUND_TYPES
+} soundType;
+
+typedef struct soundRequest
+{
+	soundType sound;
+	int volume; //0 to 32767
+	Uint64 time; //performance counter when it was triggered
+} soundRequest;
+
+typedef struct audioVoice
+{
+	const Sint16* samples; //NULL when the voice is free
+	int length;
+	int position;
+	int volume;
+} audioVoice;
+
+typedef struct audioMixer
+{
+	SDL_AudioDeviceID device; //0 if there is no sound, then nothing is played
+	int bufferSamples; //per callback, what the device asked for
+	Uint64 frequency; //of the performance counter
+	Sint16* sounds[SOUND_TYPES]; //mono at AUDIO_RATE
+	int soundLength[SOUND_TYPES];
+	/* main thread to callback */
+	soundRequest requests[AUDIO_QUEUE_SIZE];
+	volatile int requestsWritten; //only the main thread changes it
+	volatile int requestsRead; //only the callback changes it
+	/* callback to main thread, microseconds */
+	int latencies[AUDIO_QUEUE_SIZE];
+	volatile int latenciesWritten;
+	volatile int latenciesRead;
+	/* written by the callback */
+	audioVoice voices[AUDIO_VOICES];
+	volatile int callbacks;
+	volatile int stolen; //voices taken from a sound still playing
+	volatile long long mixTime; //nanoseconds spent in the callback
+	/* the main thread's counters */
+	int dropped; //requests lost because the ring was full
+	int played;
+	double reportSum; //since the last audioReport
+	int reportWorst;
+	int reportSamples;
+	double totalLatency;
+	int totalWorst;
+	int totalSamples;
+} audioMixer;
+
+bool audioOpen(audioMixer* m); // after SDL_Init, false if there is no sound (the game goes on silently)
+void audioClose(audioMixer* m);
+void audioPlay(audioMixer* m, soundType sound, int volume); // never blocks, a request is dropped if the ring is full
+void audioPlayEvents(audioMixer* m, const gameEvent* events, int count); // the sounds for the events of the game
+void audioCollect(audioMixer* m); // reads the latencies the callback sent back, the report and summary call it
+bool audioReport(audioMixer* m, char* text, int size); // for the window title, false before the first sound
+void audioSummary(audioMixer* m, FILE* out);
+
+#endif
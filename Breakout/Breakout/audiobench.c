@@ -0,0 +1,76 @@
+// benchmark for the mixer: how long a sound takes from the trigger to the output, and what the mixing costs
+// compile with: make audiobench, the sources it needs are listed in the Makefile
+// usage: audiobench [-s seconds] [-r sounds per second] [-j save the results as JSON] [-c compare with a saved JSON] [-x tolerance in %]
+// It needs no sound card: SDL_AUDIODRIVER=dummy ./audiobench, or SDL_AUDIODRIVER=disk SDL_DISKAUDIOFILE=out.raw ./audiobench
+// to listen to what was mixed afterwards (16 bit mono at 48000 Hz)
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "audio.h"
+#include "results.h"
+
+int main(int argc, char* argv[])
+{
+	double seconds = 5.0, rate = 20.0;
+	const char* jsonPath = NULL;
+	const char* baselinePath = NULL;
+	double tolerance = RESULTS_TOLERANCE;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-s") == 0) seconds = atof(argv[i + 1]);
+		else if (strcmp(argv[i], "-r") == 0) rate = atof(argv[i + 1]);
+		else if (strcmp(argv[i], "-j") == 0) jsonPath = argv[i + 1];
+		else if (strcmp(argv[i], "-c") == 0) baselinePath = argv[i + 1];
+		else if (strcmp(argv[i], "-x") == 0) tolerance = atof(argv[i + 1]) / 100.0;
+	}
+	if (rate <= 0.0) rate = 1.0;
+
+	if (SDL_Init(0) != 0) {
+		printf("cannot initialise SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+	static audioMixer mixer;
+	if (!audioOpen(&mixer)) return 1;
+	printf("audio driver %s, %d samples per callback\n", SDL_GetCurrentAudioDriver(), mixer.bufferSamples);
+
+	/* sounds at a steady rate, every few of them a burst of more than there are voices like a multiball hitting a wall of blocks */
+	Uint64 frequency = SDL_GetPerformanceFrequency(), start = SDL_GetPerformanceCounter();
+	int triggered = 0;
+	while ((SDL_GetPerformanceCounter() - start) / (double)frequency < seconds) {
+		if (triggered < (SDL_GetPerformanceCounter() - start) / (double)frequency * rate) {
+			int burst = triggered % 16 == 15 ? AUDIO_VOICES + 8 : 1;
+			for (int k = 0; k < burst; k++) audioPlay(&mixer, (soundType)((triggered + k) % SOUND_TYPES), 8000);
+			triggered++;
+		}
+		audioCollect(&mixer); //like the game, the latencies are read back while it runs
+		SDL_Delay(1);
+	}
+	SDL_Delay(800); //the last sounds end
+	audioCollect(&mixer);
+	audioClose(&mixer); //the callback has stopped, its counters can be read
+
+	int callbacks = mixer.callbacks;
+	double mean = mixer.totalSamples > 0 ? mixer.totalLatency / mixer.totalSamples / 1000.0 : 0.0, worst = mixer.totalWorst / 1000.0;
+	double mix = callbacks > 0 ? mixer.mixTime / 1000.0 / callbacks : 0.0;
+	printf("%d sounds, %d started by %d callbacks, %d dropped, %d cut short\n", mixer.played, mixer.totalSamples, callbacks, mixer.dropped, mixer.stolen);
+	printf("trigger to output %.2f ms on average, worst %.2f ms (%.2f ms of it is the buffer)\n", mean, worst, 1000.0 * mixer.bufferSamples / AUDIO_RATE);
+	printf("mixing %.2f us per callback of %.2f ms\n", mix, 1000.0 * mixer.bufferSamples / AUDIO_RATE);
+	bool lost = mixer.totalSamples != mixer.played;
+	if (lost) printf("%d sounds never reached the callback\n", mixer.played - mixer.totalSamples);
+	SDL_Quit();
+
+	resultAdd("audio/latency", mean, "ms", true);
+	resultAdd("audio/latency worst", worst, "ms", true);
+	resultAdd("audio/mix per callback", mix, "us", true);
+	if (jsonPath != NULL) {
+		if (resultsWrite(jsonPath, "audiobench")) printf("\nresults saved to %s\n", jsonPath);
+		else printf("\ncannot write %s\n", jsonPath);
+	}
+	if (baselinePath != NULL) {
+		int regressions = resultsCompare(baselinePath, tolerance, stdout);
+		if (regressions < 0) printf("cannot read the baseline %s\n", baselinePath);
+		return regressions == 0 && !lost ? 0 : 1;
+	}
+	return lost ? 1 : 0;
+}
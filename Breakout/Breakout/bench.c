@@ -0,0 +1,466 @@
+// benchmarks for the simulation, no SDL needed
+// compile with: make bench, the sources it needs are listed in the Makefile
+// usage: bench [grid] [kernel] [env] [snapshot] [raster] [micro] [soak seconds] [-t threads] [-j save the results as JSON] [-c compare with a saved JSON] [-x tolerance in %]
+//   (everything but the soak by default). With -c the exit code is 1 when something got slower than the tolerance
+
+#include "game.h"
+#include "env.h"
+#include "snapshot.h"
+#include "level.h"
+#include "results.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct field
+{
+	blockField blocks;
+	int width; //size of the world around the blocks
+	int height;
+} field;
+
+void buildField(field* fl, int numberBlocks) { //a square field of 60x30 blocks, like the real levels but as big as needed
+	int columns = (int)ceil(sqrt(numberBlocks * 2.0));
+	int rows = (numberBlocks + columns - 1) / columns;
+	int spacing = 8;
+	memset(&fl->blocks, 0, sizeof(fl->blocks));
+	blockFieldResize(&fl->blocks, numberBlocks, NULL);
+	fl->width = columns * (60 + spacing) + 2 * spacing;
+	fl->height = rows * (30 + spacing) + 2 * spacing;
+	for (int i = 0; i < numberBlocks; i++) {
+		int r = i / columns, c = i % columns;
+		double x = -fl->width / 2 + spacing + c * (60 + spacing) + 30;
+		double y = fl->height / 2 - spacing - r * (30 + spacing) - 15;
+		blockFieldSet(&fl->blocks, i, x, y, 60, 30, 1000000000); //blocks never break, so every frame costs the same
+	}
+}
+
+int linearFirstHit(ball* b, blockField* bl1) { //what updateBall did before the grid
+	for (int i = 0; i < bl1->count; i++) {
+		if (ballXblock(b, bl1, i)) return i;
+	}
+	return -1;
+}
+
+void benchGrid(int numberBlocks, int frames) {
+	field fl;
+	blockGrid grid = { 0 };
+	paddle p1;
+	ball b;
+	ballResult result;
+	candidateBuffer candidates = { 0 };
+	volatile int sink = 0;
+
+	buildField(&fl, numberBlocks);
+	gridBuild(&grid, &fl.blocks, 0.0);
+	initializePaddle(&p1, 0.0, -fl.height / 2.0 + 10.0, 40, 6, 150.0);
+	initializeBall(&b, 0.0, 0.0, 5.0, 310.0, 470.0);
+
+	clock_t start = clock();
+	for (int i = 0; i < frames; i++) {
+		updateBall(&b, GAME_STEP, &p1, &fl.blocks, &grid, fl.width, fl.height, 0.0, &result, &candidates);
+		if (result.lost) initializeBall(&b, 0.0, -30.0, 5.0, 310.0, 470.0);
+	}
+	double gridTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	int linearFrames = frames / (1 + numberBlocks / 400); //the linear scan gets slow, fewer frames are enough
+	start = clock();
+	for (int i = 0; i < linearFrames; i++) {
+		b.x = fmod(i * 7.3, fl.width) - fl.width / 2.0;
+		b.y = fmod(i * 3.1, fl.height) - fl.height / 2.0;
+		sink += linearFirstHit(&b, &fl.blocks);
+	}
+	double linearTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	printf("%8d blocks  %6dx%-6d grid %4dx%-4d  updateBall %8.1f ns/frame   linear scan %10.1f ns/frame\n",
+		numberBlocks, fl.width, fl.height, grid.columns, grid.rows,
+		gridTime * 1e9 / frames, linearTime * 1e9 / linearFrames);
+	char name[64];
+	snprintf(name, sizeof(name), "grid/updateBall/%d", numberBlocks);
+	resultAdd(name, gridTime * 1e9 / frames, "ns", true);
+	snprintf(name, sizeof(name), "grid/linear/%d", numberBlocks);
+	resultAdd(name, linearTime * 1e9 / linearFrames, "ns", true);
+
+	gridFree(&grid);
+	free(candidates.blocks);
+	blockFieldFree(&fl.blocks);
+}
+
+typedef int (*overlapKernel)(const blockField*, float, float, float, float, int);
+
+double benchKernel(field* fl, overlapKernel kernel, int scans) { //ns per block for a full scan that finds nothing
+	volatile int sink = 0;
+	clock_t start = clock();
+	for (int i = 0; i < scans; i++) {
+		sink += kernel(&fl->blocks, 1e6f + i, 1e6f, 1e6f + i + 10.0f, 1e6f + 10.0f, 0);
+	}
+	return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / ((double)scans * fl->blocks.count);
+}
+
+void benchKernels(int numberBlocks) {
+	field fl;
+	int scans = 200000000 / numberBlocks;
+	buildField(&fl, numberBlocks);
+	char name[64];
+	double scalar = benchKernel(&fl, blockFieldFirstOverlapScalar, scans), sse = benchKernel(&fl, blockFieldFirstOverlapSse, scans);
+	printf("%8d blocks  scalar %6.3f ns/block   sse2 %6.3f ns/block", numberBlocks, scalar, sse);
+	snprintf(name, sizeof(name), "kernel/scalar/%d", numberBlocks);
+	resultAdd(name, scalar, "ns/block", true);
+	snprintf(name, sizeof(name), "kernel/sse2/%d", numberBlocks);
+	resultAdd(name, sse, "ns/block", true);
+	if (blockFieldHasAvx2()) {
+		double avx = benchKernel(&fl, blockFieldFirstOverlapAvx2, scans);
+		printf("   avx2 %6.3f ns/block", avx);
+		snprintf(name, sizeof(name), "kernel/avx2/%d", numberBlocks);
+		resultAdd(name, avx, "ns/block", true);
+	}
+	printf("\n");
+	blockFieldFree(&fl.blocks);
+}
+
+double wallClock(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void benchEnv(int numberEnvs, int steps, int threads) {
+	threadPool* pool = threadPoolCreate(threads);
+	envBatch* e = envCreate(3, 640, 480, pool);
+	float* observations = malloc(numberEnvs * ENV_OBSERVATION_SIZE * sizeof(float));
+	float* rewards = malloc(numberEnvs * sizeof(float));
+	unsigned char* dones = malloc(numberEnvs);
+	int* actions = malloc(numberEnvs * sizeof(int));
+	long long episodes = 0;
+	double rewardSum = 0.0;
+
+	envReset(e, numberEnvs, NULL, observations);
+	double start = wallClock();
+	for (int t = 0; t < steps; t++) {
+		for (int i = 0; i < numberEnvs; i++) { //follow the ball, like the headless player
+			float* obs = observations + i * ENV_OBSERVATION_SIZE;
+			actions[i] = obs[1] > obs[0] + 0.02f ? 1 : (obs[1] < obs[0] - 0.02f ? -1 : 0);
+		}
+		envStep(e, actions, observations, rewards, dones);
+		for (int i = 0; i < numberEnvs; i++) {
+			rewardSum += rewards[i];
+			episodes += dones[i];
+		}
+	}
+	double seconds = wallClock() - start;
+	double perCore = (double)numberEnvs * steps / seconds / pool->numberWorkers;
+
+	printf("%6d envs  %d threads  %10.0f steps/s  %10.0f steps/s per core (target %d: %s)  %lld episodes, reward %.0f\n",
+		numberEnvs, pool->numberWorkers, (double)numberEnvs * steps / seconds, perCore, ENV_TARGET_STEPS_PER_CORE,
+		perCore >= ENV_TARGET_STEPS_PER_CORE ? "ok" : "below", episodes, rewardSum);
+	char name[64];
+	snprintf(name, sizeof(name), "env/%d", numberEnvs);
+	resultAdd(name, perCore, "steps/s", false);
+
+	envDestroy(e);
+	threadPoolDestroy(pool);
+	free(observations);
+	free(rewards);
+	free(dones);
+	free(actions);
+}
+
+void benchRaster(int numberEnvs, int width, int height, rasterFormat format, int threads) { //pictures of games in the middle of playing
+	threadPool* pool = threadPoolCreate(threads);
+	envBatch* e = envCreate(3, 640, 480, pool);
+	float* observations = malloc(numberEnvs * ENV_OBSERVATION_SIZE * sizeof(float));
+	float* rewards = malloc(numberEnvs * sizeof(float));
+	unsigned char* dones = malloc(numberEnvs);
+	int* actions = calloc(numberEnvs, sizeof(int));
+	unsigned char* frames = malloc(numberEnvs * rasterFrameSize(width, height, format));
+	envReset(e, numberEnvs, NULL, observations);
+	for (int t = 0; t < 600; t++) envStep(e, actions, observations, rewards, dones); //some blocks broken, some powerups falling
+
+	int reps = 1000000 / numberEnvs + 1;
+	double start = wallClock();
+	for (int r = 0; r < reps; r++) envRender(e, frames, width, height, format);
+	double seconds = wallClock() - start;
+	double perSecond = (double)numberEnvs * reps / seconds;
+	printf("%6d envs  %3dx%-3d %-4s  %d threads  %10.0f frames/s  %8.0f frames/s per core (target %d: %s)\n", numberEnvs, width, height,
+		format == RASTER_GRAY ? "gray" : "rgb", pool->numberWorkers, perSecond, perSecond / pool->numberWorkers, ENV_TARGET_FRAMES,
+		perSecond >= ENV_TARGET_FRAMES ? "ok" : "below");
+	char name[64];
+	snprintf(name, sizeof(name), "raster/%dx%d/%s", width, height, format == RASTER_GRAY ? "gray" : "rgb");
+	resultAdd(name, perSecond / pool->numberWorkers, "frames/s", false);
+
+	envDestroy(e);
+	threadPoolDestroy(pool);
+	free(observations);
+	free(rewards);
+	free(dones);
+	free(actions);
+	free(frames);
+}
+
+void benchSnapshot(int level, int numberBlocks) { //save and restore in the middle of a game, numberBlocks 0 plays a built in level
+	gameState game = { 0 };
+	gameInput input = { 0 };
+	gameSnapshot base = { 0 }, snap = { 0 }, delta = { 0 };
+	if (numberBlocks > 0) gameInit(&game, 4, numberBlocks, (int)sqrt(numberBlocks / 2.0), 640, 480, 1);
+	else gameInitLevel(&game, level, 640, 480, 1);
+	snapshotSave(&base, &game);
+	for (int i = 0; i < 3000 && game.status == GAME_PLAYING; i++) { //break some blocks first
+		input.p1dir = game.balls[0].x > game.paddle.x ? 1 : -1;
+		gameStep(&game, &input, GAME_STEP);
+	}
+	int reps = numberBlocks > 0 ? 2000000 / numberBlocks + 1 : 1000000;
+	double start = wallClock();
+	for (int i = 0; i < reps; i++) snapshotSave(&snap, &game);
+	double save = (wallClock() - start) * 1e9 / reps;
+	start = wallClock();
+	for (int i = 0; i < reps; i++) snapshotRestore(&game, &snap, NULL);
+	double restore = (wallClock() - start) * 1e9 / reps;
+	start = wallClock();
+	for (int i = 0; i < reps; i++) snapshotSaveDelta(&delta, &game, &base);
+	double saveDelta = (wallClock() - start) * 1e9 / reps;
+	start = wallClock();
+	for (int i = 0; i < reps; i++) snapshotRestore(&game, &delta, &base);
+	double restoreDelta = (wallClock() - start) * 1e9 / reps;
+
+	printf("%8d blocks  full %7zu bytes  save %9.1f ns  restore %9.1f ns   delta %7zu bytes  save %9.1f ns  restore %9.1f ns\n",
+		game.blocks.count, snap.size, save, restore, delta.size, saveDelta, restoreDelta);
+	char name[64];
+	snprintf(name, sizeof(name), "snapshot/save/%d", game.blocks.count);
+	resultAdd(name, save, "ns", true);
+	snprintf(name, sizeof(name), "snapshot/restore/%d", game.blocks.count);
+	resultAdd(name, restore, "ns", true);
+	snprintf(name, sizeof(name), "snapshot/saveDelta/%d", game.blocks.count);
+	resultAdd(name, saveDelta, "ns", true);
+	snprintf(name, sizeof(name), "snapshot/restoreDelta/%d", game.blocks.count);
+	resultAdd(name, restoreDelta, "ns", true);
+	snapshotFree(&base);
+	snapshotFree(&snap);
+	snapshotFree(&delta);
+	gameFree(&game);
+}
+
+#define BENCH_POSITIONS 1024 //the ball goes around these, worked out before the clock starts
+
+void benchCollisions(int numberBlocks) { //the narrow phase on its own: a ball against one block at a time, all over the field
+	field fl;
+	ball b;
+	double positions[BENCH_POSITIONS][2];
+	volatile int sink = 0;
+	int calls = 20000000;
+	buildField(&fl, numberBlocks);
+	initializeBall(&b, 0.0, 0.0, 5.0, 0.0, 0.0);
+	for (int i = 0; i < BENCH_POSITIONS; i++) {
+		positions[i][0] = (i * 37 % fl.width) - fl.width / 2.0;
+		positions[i][1] = (i * 13 % fl.height) - fl.height / 2.0;
+	}
+	clock_t start = clock();
+	for (int i = 0, block = 0; i < calls; i++) {
+		b.x = positions[i & (BENCH_POSITIONS - 1)][0];
+		b.y = positions[i & (BENCH_POSITIONS - 1)][1];
+		sink += ballXblock(&b, &fl.blocks, block);
+		if (++block == numberBlocks) block = 0;
+	}
+	double perCall = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / calls;
+	printf("%8d blocks  ballXblock %6.2f ns/call\n", numberBlocks, perCall);
+	char name[64];
+	snprintf(name, sizeof(name), "micro/ballXblock/%d", numberBlocks);
+	resultAdd(name, perCall, "ns", true);
+	blockFieldFree(&fl.blocks);
+}
+
+void benchPaddle(void) {
+	paddle p1;
+	ball b;
+	double positions[BENCH_POSITIONS][2];
+	volatile int sink = 0;
+	int calls = 50000000;
+	initializePaddle(&p1, 0.0, -200.0, 40, 6, 150.0);
+	initializeBall(&b, 0.0, 0.0, 5.0, 0.0, 0.0);
+	for (int i = 0; i < BENCH_POSITIONS; i++) { //around the paddle, about half of them on it
+		positions[i][0] = (i * 7 % 100) - 50.0;
+		positions[i][1] = -200.0 + (i * 3 % 12) - 6.0;
+	}
+	clock_t start = clock();
+	for (int i = 0; i < calls; i++) {
+		b.x = positions[i & (BENCH_POSITIONS - 1)][0];
+		b.y = positions[i & (BENCH_POSITIONS - 1)][1];
+		sink += ballXpaddle(&b, &p1);
+	}
+	double perCall = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / calls;
+	printf("          ballXpaddle %6.2f ns/call\n", perCall);
+	resultAdd("micro/ballXpaddle", perCall, "ns", true);
+}
+
+void benchPowerups(int numberPowerups) { //the scan gameStep does over the falling powerups, none of them caught
+	paddle p1;
+	powerup* pows = malloc(numberPowerups * sizeof(powerup));
+	volatile int sink = 0;
+	int steps = 200000000 / numberPowerups;
+	initializePaddle(&p1, 0.0, -200.0, 40, 6, 150.0);
+	clock_t start = clock();
+	for (int t = 0; t < steps; t++) {
+		if (t % 100 == 0) for (int i = 0; i < numberPowerups; i++) pows[i] = initializePowerup((i * 37 % 600) - 300.0, 240.0, (powerupType)(i % POWERUP_TYPES));
+		for (int i = 0; i < numberPowerups; i++) sink += updatePowerup(&pows[i], &p1, GAME_STEP);
+	}
+	double perPowerup = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / ((double)steps * numberPowerups);
+	printf("%8d powerups  updatePowerup %6.2f ns/powerup\n", numberPowerups, perPowerup);
+	char name[64];
+	snprintf(name, sizeof(name), "micro/updatePowerup/%d", numberPowerups);
+	resultAdd(name, perPowerup, "ns", true);
+	free(pows);
+}
+
+void benchSetup(const char* label, int level, int numberBlocks, const levelPack* pack) { //starting a level: a built in one, a generated one of numberBlocks or one of the pack
+	gameState game = { 0 };
+	int reps = numberBlocks > 0 ? 20000000 / numberBlocks + 1 : 20000;
+	double start = wallClock();
+	for (int i = 0; i < reps; i++) {
+		if (pack != NULL) gameInitPacked(&game, pack, level, 640, 480, (unsigned int)i);
+		else if (numberBlocks > 0) gameInit(&game, 4, numberBlocks, (int)sqrt(numberBlocks / 2.0), 640, 480, (unsigned int)i);
+		else gameInitLevel(&game, level, 640, 480, (unsigned int)i);
+	}
+	double perSetup = (wallClock() - start) * 1e6 / reps;
+	printf("%-24s %6d blocks  %9.2f us/setup\n", label, game.blocks.count, perSetup);
+	char name[64];
+	snprintf(name, sizeof(name), "setup/%s", label);
+	resultAdd(name, perSetup, "us", true);
+	gameFree(&game);
+}
+
+void benchSoak(double seconds) { //scripted games one after the other on every level, like a kiosk left running
+	gameState game = { 0 };
+	gameInput input = { 0 };
+	int level = 1, games = 0;
+	unsigned int seed = 1;
+	long long steps = 0, windowSteps = 0;
+	double slowest = 0.0;
+	gameInitLevel(&game, level, 640, 480, seed);
+	double start = wallClock(), windowStart = start, now = start;
+	while (now - start < seconds) {
+		for (int i = 0; i < 10000; i++) {
+			input.p1dir = game.balls[0].x > game.paddle.x + 5.0 ? 1 : (game.balls[0].x < game.paddle.x - 5.0 ? -1 : 0);
+			gameStep(&game, &input, GAME_STEP);
+			if (game.status != GAME_PLAYING) {
+				games++;
+				level = level % LEVELS_NUMBER + 1;
+				gameInitLevel(&game, level, 640, 480, ++seed);
+			}
+		}
+		steps += 10000;
+		windowSteps += 10000;
+		now = wallClock();
+		if (now - windowStart >= 1.0) { //the slowest second shows a run that gets slower as it goes
+			double rate = windowSteps / (now - windowStart);
+			if (slowest == 0.0 || rate < slowest) slowest = rate;
+			windowStart = now;
+			windowSteps = 0;
+		}
+	}
+	double rate = steps / (now - start);
+	printf("%lld steps in %.1f s: %.0f steps/s, slowest second %.0f steps/s, %d games finished\n", steps, now - start, rate, slowest, games);
+	resultAdd("soak/steps", rate, "steps/s", false);
+	if (slowest > 0.0) resultAdd("soak/slowestSecond", slowest, "steps/s", false);
+	gameFree(&game);
+}
+
+int main(int argc, char* argv[])
+{
+	int sizes[] = { 40, 400, 4000, 40000, 100000 };
+	int envs[] = { 1, 64, 1024, 8192 };
+	bool grid = true, kernels = true, env = true, snapshots = true, raster = true, micro = true;
+	double soak = 0.0; //seconds
+	int threads = 0;
+	const char* jsonPath = NULL;
+	const char* baselinePath = NULL;
+	double tolerance = RESULTS_TOLERANCE;
+
+	if (argc > 1) grid = kernels = env = snapshots = raster = micro = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "grid") == 0) grid = true;
+		else if (strcmp(argv[i], "kernel") == 0) kernels = true;
+		else if (strcmp(argv[i], "env") == 0) env = true;
+		else if (strcmp(argv[i], "snapshot") == 0) snapshots = true;
+		else if (strcmp(argv[i], "raster") == 0) raster = true;
+		else if (strcmp(argv[i], "micro") == 0) micro = true;
+		else if (strcmp(argv[i], "soak") == 0) soak = i + 1 < argc && atof(argv[i + 1]) > 0.0 ? atof(argv[++i]) : 60.0;
+		else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) jsonPath = argv[++i];
+		else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) baselinePath = argv[++i];
+		else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc) tolerance = atof(argv[++i]) / 100.0;
+	}
+	if (!grid && !kernels && !env && !snapshots && !raster && !micro && soak == 0.0) grid = kernels = env = snapshots = raster = micro = true;
+
+	if (grid) {
+		printf("ball vs blocks broadphase, per frame cost\n");
+		for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+			benchGrid(sizes[i], 2000000);
+		}
+	}
+	if (kernels) {
+		printf("\nball vs blocks overlap kernel, full scan (dispatch picks %s)\n", blockFieldKernelName());
+		for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+			benchKernels(sizes[i]);
+		}
+	}
+	if (env) {
+		printf("\nvectorized environment, level 3\n");
+		for (int i = 0; i < (int)(sizeof(envs) / sizeof(envs[0])); i++) {
+			benchEnv(envs[i], 8000000 / (envs[i] * 4) + 1, threads);
+		}
+	}
+	if (snapshots) {
+		printf("\nsnapshots, levels 1 to %d and bigger fields\n", LEVELS_NUMBER);
+		for (int level = 1; level <= LEVELS_NUMBER; level++) benchSnapshot(level, 0);
+		for (int i = 2; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) benchSnapshot(0, sizes[i]);
+	}
+	if (raster) {
+		printf("\nobservation pictures, level 3\n");
+		benchRaster(1024, RASTER_ATARI_WIDTH, RASTER_ATARI_HEIGHT, RASTER_GRAY, threads);
+		benchRaster(1024, RASTER_ATARI_WIDTH, RASTER_ATARI_HEIGHT, RASTER_RGB, threads);
+		benchRaster(1024, RASTER_SMALL_WIDTH, RASTER_SMALL_HEIGHT, RASTER_GRAY, threads);
+		benchRaster(1024, RASTER_SMALL_WIDTH, RASTER_SMALL_HEIGHT, RASTER_RGB, threads);
+	}
+	if (micro) {
+		printf("\ncollision tests\n");
+		for (int i = 0; i < 3; i++) benchCollisions(sizes[i]);
+		benchPaddle();
+		printf("\nfalling powerups\n");
+		benchPowerups(16);
+		benchPowerups(1024);
+		printf("\nlevel setup\n");
+		char label[32];
+		for (int level = 1; level <= LEVELS_NUMBER; level++) {
+			snprintf(label, sizeof(label), "level %d", level);
+			benchSetup(label, level, 0, NULL);
+		}
+		for (int i = 1; i < 4; i++) {
+			snprintf(label, sizeof(label), "generated %d", sizes[i]);
+			benchSetup(label, 0, sizes[i], NULL);
+		}
+		levelPack pack;
+		if (levelPackOpen(&pack, "levels/levels.bkl")) {
+			for (int level = 0; level < levelPackCount(&pack); level++) {
+				snprintf(label, sizeof(label), "pack %s", levelPackName(&pack, level));
+				benchSetup(label, level, 0, &pack);
+			}
+			levelPackClose(&pack);
+		}
+	}
+	if (soak > 0.0) {
+		printf("\nsoak, levels 1 to %d over and over for %.0f s\n", LEVELS_NUMBER, soak);
+		benchSoak(soak);
+	}
+
+	if (jsonPath != NULL) {
+		if (resultsWrite(jsonPath, "bench")) printf("\nresults saved to %s\n", jsonPath);
+		else printf("\ncannot write %s\n", jsonPath);
+	}
+	if (baselinePath != NULL) {
+		int regressions = resultsCompare(baselinePath, tolerance, stdout);
+		if (regressions < 0) printf("cannot read the baseline %s\n", baselinePath);
+		return regressions == 0 ? 0 : 1;
+	}
+	return 0;
+}
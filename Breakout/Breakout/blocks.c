@@ -0,0 +1,278 @@
+// structure of arrays storage for the blocks and the SIMD kernel that tests a box against them
+
+#include "blocks.h"
+#include "simd.h"
+#include "thread.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int blockCapacity(int count) {
+	int capacity = (count + 31) & ~31;
+	return capacity == 0 ? 32 : capacity;
+}
+
+static int pickKernel(void);
+
+static void releaseArrays(blockField* f) { //the field is about to get new arrays
+	if (f->owned) {
+		if (!f->mapped) {
+			free(f->x);
+			free(f->y);
+			free(f->halfWidth);
+			free(f->halfHeight);
+		}
+		free(f->strength);
+		free(f->alive);
+		free(f->fixedMinX);
+		free(f->fixedMinY);
+		free(f->fixedMaxX);
+		free(f->fixedMaxY);
+	}
+	f->x = f->y = f->halfWidth = f->halfHeight = f->strength = NULL;
+	f->alive = NULL;
+	f->fixedMinX = f->fixedMinY = f->fixedMaxX = f->fixedMaxY = NULL;
+	f->capacity = 0;
+	f->owned = false;
+	f->mapped = false;
+}
+
+size_t blockFieldArenaSize(int count, bool mapped) {
+	size_t capacity = blockCapacity(count);
+	return (mapped ? 1 : 5) * arenaRound(capacity * sizeof(float)) + arenaRound(capacity / 32 * sizeof(unsigned int)) +
+		(GAME_FIXED_POINT ? 4 * arenaRound(capacity * sizeof(fixed)) : 0);
+}
+
+static void setFixedBox(blockField* f, int i) {
+	if (f->fixedMinX == NULL) return;
+	fixed x = TO_FIXED(f->x[i]), y = TO_FIXED(f->y[i]), halfWidth = TO_FIXED(f->halfWidth[i]), halfHeight = TO_FIXED(f->halfHeight[i]);
+	f->fixedMinX[i] = x - halfWidth;
+	f->fixedMinY[i] = y - halfHeight;
+	f->fixedMaxX[i] = x + halfWidth;
+	f->fixedMaxY[i] = y + halfHeight;
+}
+
+void blockFieldResize(blockField* f, int count, arena* a) {
+	int capacity = blockCapacity(count);
+	if (a != NULL) {
+		releaseArrays(f);
+		f->x = arenaAlloc(a, capacity * sizeof(float));
+		f->y = arenaAlloc(a, capacity * sizeof(float));
+		f->halfWidth = arenaAlloc(a, capacity * sizeof(float));
+		f->halfHeight = arenaAlloc(a, capacity * sizeof(float));
+		f->strength = arenaAlloc(a, capacity * sizeof(float));
+		f->alive = arenaAlloc(a, capacity / 32 * sizeof(unsigned int));
+		if (GAME_FIXED_POINT) {
+			f->fixedMinX = arenaAlloc(a, capacity * sizeof(fixed));
+			f->fixedMinY = arenaAlloc(a, capacity * sizeof(fixed));
+			f->fixedMaxX = arenaAlloc(a, capacity * sizeof(fixed));
+			f->fixedMaxY = arenaAlloc(a, capacity * sizeof(fixed));
+		}
+		f->capacity = capacity;
+	}
+	else {
+		if (!f->owned) releaseArrays(f); //start new heap arrays, the old ones are not ours
+		f->owned = true;
+		if (capacity > f->capacity) {
+			f->x = realloc(f->x, capacity * sizeof(float));
+			f->y = realloc(f->y, capacity * sizeof(float));
+			f->halfWidth = realloc(f->halfWidth, capacity * sizeof(float));
+			f->halfHeight = realloc(f->halfHeight, capacity * sizeof(float));
+			f->strength = realloc(f->strength, capacity * sizeof(float));
+			f->alive = realloc(f->alive, capacity / 32 * sizeof(unsigned int));
+			if (GAME_FIXED_POINT) {
+				f->fixedMinX = realloc(f->fixedMinX, capacity * sizeof(fixed));
+				f->fixedMinY = realloc(f->fixedMinY, capacity * sizeof(fixed));
+				f->fixedMaxX = realloc(f->fixedMaxX, capacity * sizeof(fixed));
+				f->fixedMaxY = realloc(f->fixedMaxY, capacity * sizeof(fixed));
+			}
+			f->capacity = capacity;
+		}
+	}
+	f->count = count;
+	f->kernel = pickKernel();
+	memset(f->x, 0, f->capacity * sizeof(float));
+	memset(f->y, 0, f->capacity * sizeof(float));
+	memset(f->halfWidth, 0, f->capacity * sizeof(float));
+	memset(f->halfHeight, 0, f->capacity * sizeof(float));
+	memset(f->strength, 0, f->capacity * sizeof(float));
+	memset(f->alive, 0, f->capacity / 32 * sizeof(unsigned int));
+	if (f->fixedMinX != NULL) {
+		memset(f->fixedMinX, 0, f->capacity * sizeof(fixed));
+		memset(f->fixedMinY, 0, f->capacity * sizeof(fixed));
+		memset(f->fixedMaxX, 0, f->capacity * sizeof(fixed));
+		memset(f->fixedMaxY, 0, f->capacity * sizeof(fixed));
+	}
+	f->aliveCount = 0;
+}
+
+void blockFieldMap(blockField* f, int count, const float* x, const float* y, const float* halfWidth, const float* halfHeight, const float* strength, arena* a) {
+	int capacity = blockCapacity(count);
+	releaseArrays(f);
+	f->strength = arenaAlloc(a, capacity * sizeof(float));
+	f->alive = arenaAlloc(a, capacity / 32 * sizeof(unsigned int));
+	f->capacity = capacity;
+	f->x = (float*)x;
+	f->y = (float*)y;
+	f->halfWidth = (float*)halfWidth;
+	f->halfHeight = (float*)halfHeight;
+	if (GAME_FIXED_POINT) {
+		f->fixedMinX = arenaAlloc(a, capacity * sizeof(fixed));
+		f->fixedMinY = arenaAlloc(a, capacity * sizeof(fixed));
+		f->fixedMaxX = arenaAlloc(a, capacity * sizeof(fixed));
+		f->fixedMaxY = arenaAlloc(a, capacity * sizeof(fixed));
+		for (int i = 0; i < capacity; i++) setFixedBox(f, i);
+	}
+	f->mapped = true;
+	f->count = count;
+	f->kernel = pickKernel();
+	memcpy(f->strength, strength, capacity * sizeof(float));
+	memset(f->alive, 0, f->capacity / 32 * sizeof(unsigned int));
+	memset(f->alive, 0xff, count / 32 * sizeof(unsigned int)); //every block of a level starts alive
+	if (count & 31) f->alive[count / 32] = (1u << (count & 31)) - 1;
+	f->aliveCount = count;
+}
+
+void blockFieldSet(blockField* f, int i, double x, double y, double w, double h, int strength) {
+	f->x[i] = (float)x;
+	f->y[i] = (float)y;
+	f->halfWidth[i] = (float)(w / 2.0);
+	f->halfHeight[i] = (float)(h / 2.0);
+	f->strength[i] = (float)strength;
+	setFixedBox(f, i);
+	if (!BLOCK_ALIVE(f, i)) f->aliveCount++;
+	f->alive[i >> 5] |= 1u << (i & 31);
+}
+
+void blockFieldKill(blockField* f, int i) {
+	if (BLOCK_ALIVE(f, i)) f->aliveCount--;
+	f->alive[i >> 5] &= ~(1u << (i & 31));
+}
+
+static int lowestBit(unsigned int v) { //v is never 0
+	int n = 0;
+	while (!(v & 1u)) {
+		v >>= 1;
+		n++;
+	}
+	return n;
+}
+
+int blockFieldAliveCount(const blockField* f) {
+	return f->aliveCount;
+}
+
+void blockFieldFree(blockField* f) {
+	releaseArrays(f);
+	memset(f, 0, sizeof(*f));
+}
+
+int blockFieldFirstOverlapScalar(const blockField* f, float minX, float minY, float maxX, float maxY, int start) {
+	for (int i = start; i < f->count; i++) {
+		if (BLOCK_ALIVE(f, i) &&
+			f->x[i] - f->halfWidth[i] <= maxX && f->x[i] + f->halfWidth[i] >= minX &&
+			f->y[i] - f->halfHeight[i] <= maxY && f->y[i] + f->halfHeight[i] >= minY) return i;
+	}
+	return -1;
+}
+
+#ifdef SIMD_X86
+
+TARGET_SSE2 int blockFieldFirstOverlapSse(const blockField* f, float minX, float minY, float maxX, float maxY, int start) {
+	__m128 vMinX = _mm_set1_ps(minX), vMinY = _mm_set1_ps(minY);
+	__m128 vMaxX = _mm_set1_ps(maxX), vMaxY = _mm_set1_ps(maxY);
+	for (int i = start & ~3; i < f->count; i += 4) { //the arrays are padded, reading past count is fine
+		unsigned int lanes = (f->alive[i >> 5] >> (i & 31)) & 0xfu;
+		if (i < start) lanes &= ~0u << (start - i);
+		if (!lanes) continue;
+		__m128 x = _mm_loadu_ps(f->x + i), hw = _mm_loadu_ps(f->halfWidth + i);
+		__m128 y = _mm_loadu_ps(f->y + i), hh = _mm_loadu_ps(f->halfHeight + i);
+		__m128 in = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(_mm_sub_ps(x, hw), vMaxX), _mm_cmpge_ps(_mm_add_ps(x, hw), vMinX)),
+			_mm_and_ps(_mm_cmple_ps(_mm_sub_ps(y, hh), vMaxY), _mm_cmpge_ps(_mm_add_ps(y, hh), vMinY)));
+		unsigned int hits = (unsigned int)_mm_movemask_ps(in) & lanes;
+		if (hits) {
+			int hit = i + lowestBit(hits);
+			return hit < f->count ? hit : -1;
+		}
+	}
+	return -1;
+}
+
+TARGET_AVX2 int blockFieldFirstOverlapAvx2(const blockField* f, float minX, float minY, float maxX, float maxY, int start) {
+	__m256 vMinX = _mm256_set1_ps(minX), vMinY = _mm256_set1_ps(minY);
+	__m256 vMaxX = _mm256_set1_ps(maxX), vMaxY = _mm256_set1_ps(maxY);
+	for (int i = start & ~7; i < f->count; i += 8) { //8 blocks per comparison
+		unsigned int lanes = (f->alive[i >> 5] >> (i & 31)) & 0xffu;
+		if (i < start) lanes &= ~0u << (start - i);
+		if (!lanes) continue; //a group of destroyed blocks is skipped without touching the geometry
+		__m256 x = _mm256_loadu_ps(f->x + i), hw = _mm256_loadu_ps(f->halfWidth + i);
+		__m256 y = _mm256_loadu_ps(f->y + i), hh = _mm256_loadu_ps(f->halfHeight + i);
+		__m256 in = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(x, hw), vMaxX, _CMP_LE_OQ), _mm256_cmp_ps(_mm256_add_ps(x, hw), vMinX, _CMP_GE_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(y, hh), vMaxY, _CMP_LE_OQ), _mm256_cmp_ps(_mm256_add_ps(y, hh), vMinY, _CMP_GE_OQ)));
+		unsigned int hits = (unsigned int)_mm256_movemask_ps(in) & lanes;
+		if (hits) {
+			int hit = i + lowestBit(hits);
+			return hit < f->count ? hit : -1;
+		}
+	}
+	return -1;
+}
+
+bool blockFieldHasAvx2(void) {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	if (!((info[2] >> 27) & 1) || !((info[2] >> 28) & 1)) return false; //the OS has to save the AVX registers
+	if ((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] >> 5) & 1;
+#else
+	return false;
+#endif
+}
+
+#else
+
+int blockFieldFirstOverlapSse(const blockField* f, float minX, float minY, float maxX, float maxY, int start) {
+	return blockFieldFirstOverlapScalar(f, minX, minY, maxX, maxY, start);
+}
+
+int blockFieldFirstOverlapAvx2(const blockField* f, float minX, float minY, float maxX, float maxY, int start) {
+	return blockFieldFirstOverlapScalar(f, minX, minY, maxX, maxY, start);
+}
+
+bool blockFieldHasAvx2(void) {
+	return false;
+}
+
+#endif
+
+typedef int (*overlapKernel)(const blockField*, float, float, float, float, int);
+static const overlapKernel kernels[] = { blockFieldFirstOverlapScalar, blockFieldFirstOverlapSse, blockFieldFirstOverlapAvx2 };
+static const char* kernelNames[] = { "scalar", "sse2", "avx2" };
+static volatile int kernelChoice = -1; //-1 until the CPU was checked, published atomically since the loader thread may resize a field too
+
+static int pickKernel(void) {
+	int choice = atomicLoad(&kernelChoice);
+	if (choice >= 0) return choice;
+#ifdef SIMD_X86
+	choice = blockFieldHasAvx2() ? 2 : 1;
+#else
+	choice = 0;
+#endif
+	atomicStore(&kernelChoice, choice); //everybody computes the same answer, so it does not matter who stores it first
+	return choice;
+}
+
+int blockFieldFirstOverlap(const blockField* f, float minX, float minY, float maxX, float maxY, int start) {
+	return kernels[f->kernel](f, minX, minY, maxX, maxY, start);
+}
+
+const char* blockFieldKernelName(void) {
+	return kernelNames[pickKernel()];
+}
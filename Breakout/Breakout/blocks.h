@@ -0,0 +1,54 @@
+#ifndef BLOCKS_H
+#define BLOCKS_H
+
+// the blocks of a level, stored as one array per field (structure of arrays) so they can be tested 8 at a time
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+#include "fixed.h"
+
+typedef struct blockField
+{
+	int count;
+	int capacity; //always a multiple of 32, the padding blocks are never alive
+	float* x; //centre of the block
+	float* y;
+	float* halfWidth;
+	float* halfHeight;
+	float* strength; //number of hits needed to destroy a block
+	unsigned int* alive; //one bit per block, 0 once the block is destroyed
+	fixed* fixedMinX; //the sides of every box on the 16.16 grid, kept only in the GAME_FIXED build (NULL in the other)
+	fixed* fixedMinY; //so the integer sweep in fixed.c does not convert the floats of every candidate again
+	fixed* fixedMaxX;
+	fixed* fixedMaxY;
+	int aliveCount; //kept up to date by blockFieldSet and blockFieldKill, so nobody has to count the bits
+	bool mapped; //x, y, halfWidth and halfHeight point into a level file (see level.h) and must not be written
+	bool owned; //the arrays were allocated on the heap and blockFieldFree frees them, otherwise they belong to an arena
+	int kernel; //which blockFieldFirstOverlap version to use, set by blockFieldResize and blockFieldMap (0 is plain C, 1 SSE2, 2 AVX2)
+} blockField;
+
+#define BLOCK_ALIVE(f, i) (((f)->alive[(i) >> 5] >> ((i) & 31)) & 1u)
+
+// every block starts destroyed until blockFieldSet is called. The arrays are taken from the arena, or from the heap if it is NULL
+void blockFieldResize(blockField* f, int count, arena* a);
+// uses the positions and sizes in place (capacity floats each, the padding zeroed), only the strengths are copied
+// into the arena because they change
+void blockFieldMap(blockField* f, int count, const float* x, const float* y, const float* halfWidth, const float* halfHeight, const float* strength, arena* a);
+size_t blockFieldArenaSize(int count, bool mapped); // what blockFieldResize (or blockFieldMap if mapped) takes from an arena
+void blockFieldSet(blockField* f, int i, double x, double y, double w, double h, int strength);
+void blockFieldKill(blockField* f, int i);
+int blockFieldAliveCount(const blockField* f); // blocks not destroyed yet
+void blockFieldFree(blockField* f);
+
+/* first alive block from index start on that overlaps the box, -1 if there is none.
+   The fastest version the CPU supports (AVX2, SSE2 or plain C) is picked when the field is resized or mapped, so
+   the pool workers only ever read it */
+int blockFieldFirstOverlap(const blockField* f, float minX, float minY, float maxX, float maxY, int start);
+int blockFieldFirstOverlapScalar(const blockField* f, float minX, float minY, float maxX, float maxY, int start);
+int blockFieldFirstOverlapSse(const blockField* f, float minX, float minY, float maxX, float maxY, int start);
+int blockFieldFirstOverlapAvx2(const blockField* f, float minX, float minY, float maxX, float maxY, int start);
+bool blockFieldHasAvx2(void);
+const char* blockFieldKernelName(void);
+
+#endif
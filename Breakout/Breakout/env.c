@@ -0,0 +1,103 @@
+// vectorized environment: N games in one array, stepped in parallel on the thread pool
+
+#include "env.h"
+#include <stdlib.h>
+#include <string.h>
+
+envBatch* envCreate(int level, int winWidth, int winHeight, threadPool* pool) {
+	envBatch* e = calloc(1, sizeof(envBatch));
+	e->level = level;
+	e->winWidth = winWidth;
+	e->winHeight = winHeight;
+	e->repeat = 1;
+	e->pool = pool;
+	return e;
+}
+
+static void observe(envBatch* e, int i, float* obs) { //everything is scaled to about -1..1
+	gameState* s = &e->games[i];
+	ball* b = &s->balls[0];
+	float halfWidth = e->winWidth / 2.0f, halfHeight = e->winHeight / 2.0f;
+	obs[0] = (float)s->paddle.x / halfWidth;
+	obs[1] = (float)b->x / halfWidth;
+	obs[2] = (float)b->y / halfHeight;
+	obs[3] = (float)b->speedX / 500.0f;
+	obs[4] = (float)b->speedY / 500.0f;
+	obs[5] = (float)s->paddle.lives / 10.0f;
+	obs[6] = s->blocks.count > 0 ? (float)e->blocksLeft[i] / s->blocks.count : 0.0f;
+	obs[7] = (float)s->numberBalls / 100.0f;
+}
+
+static void resetOne(envBatch* e, int i) {
+	gameInitLevel(&e->games[i], e->level, e->winWidth, e->winHeight, e->seeds[i]);
+	e->seeds[i] += e->numberEnvs; //the next game of this env gets a seed no other env uses
+	e->blocksLeft[i] = blockFieldAliveCount(&e->games[i].blocks);
+}
+
+void envReset(envBatch* e, int numberEnvs, const unsigned int* seeds, float* observations) {
+	if (numberEnvs != e->numberEnvs) {
+		for (int i = numberEnvs; i < e->numberEnvs; i++) gameFree(&e->games[i]);
+		e->games = realloc(e->games, numberEnvs * sizeof(gameState));
+		e->seeds = realloc(e->seeds, numberEnvs * sizeof(unsigned int));
+		e->blocksLeft = realloc(e->blocksLeft, numberEnvs * sizeof(int));
+		if (numberEnvs > e->numberEnvs) memset(e->games + e->numberEnvs, 0, (numberEnvs - e->numberEnvs) * sizeof(gameState));
+		e->numberEnvs = numberEnvs;
+	}
+	for (int i = 0; i < numberEnvs; i++) {
+		e->seeds[i] = seeds != NULL ? seeds[i] : (unsigned int)i + 1;
+		resetOne(e, i);
+		if (observations != NULL) observe(e, i, observations + i * ENV_OBSERVATION_SIZE);
+	}
+}
+
+void envStepTask(void* data, int begin, int end, int worker) {
+	envBatch* e = data;
+	(void)worker;
+	for (int i = begin; i < end; i++) {
+		gameState* s = &e->games[i];
+		gameInput input = { 0 };
+		int lives = s->paddle.lives;
+		input.p1dir = e->actions[i];
+		for (int r = 0; r < e->repeat && s->status == GAME_PLAYING; r++) gameStep(s, &input, GAME_STEP);
+
+		int blocksLeft = blockFieldAliveCount(&s->blocks);
+		float reward = (float)(e->blocksLeft[i] - blocksLeft);
+		if (s->paddle.lives < lives) reward -= (float)(lives - s->paddle.lives);
+		e->blocksLeft[i] = blocksLeft;
+		e->rewards[i] = reward;
+		e->dones[i] = s->status != GAME_PLAYING;
+		if (e->dones[i]) resetOne(e, i);
+		observe(e, i, e->observations + i * ENV_OBSERVATION_SIZE);
+	}
+}
+
+void envStep(envBatch* e, const int* actions, float* observations, float* rewards, unsigned char* dones) {
+	e->actions = actions;
+	e->observations = observations;
+	e->rewards = rewards;
+	e->dones = dones;
+	threadPoolFor(e->pool, e->numberEnvs, 32, envStepTask, e);
+}
+
+void envRenderTask(void* data, int begin, int end, int worker) {
+	envBatch* e = data;
+	size_t size = rasterFrameSize(e->frameWidth, e->frameHeight, e->frameFormat);
+	(void)worker;
+	for (int i = begin; i < end; i++) rasterGame(&e->games[i], e->frames + i * size, e->frameWidth, e->frameHeight, e->frameFormat);
+}
+
+void envRender(envBatch* e, unsigned char* frames, int width, int height, rasterFormat format) {
+	e->frames = frames;
+	e->frameWidth = width;
+	e->frameHeight = height;
+	e->frameFormat = format;
+	threadPoolFor(e->pool, e->numberEnvs, 32, envRenderTask, e);
+}
+
+void envDestroy(envBatch* e) {
+	for (int i = 0; i < e->numberEnvs; i++) gameFree(&e->games[i]);
+	free(e->games);
+	free(e->seeds);
+	free(e->blocksLeft);
+	free(e);
+}
@@ -0,0 +1,45 @@
+#ifndef ENV_H
+#define ENV_H
+
+// many games stepped together for bots: reset(N, seeds) and step(actions) -> observations, rewards, dones
+
+#include "game.h"
+#include "raster.h"
+
+#define ENV_OBSERVATION_SIZE 8 // paddle x, ball x, ball y, ball speed x, ball speed y, lives, blocks left, balls
+#define ENV_TARGET_STEPS_PER_CORE 2000000 // what the env benchmark checks against, steps/s on one core
+#define ENV_TARGET_FRAMES 200000 // what the raster benchmark checks against, pictures/s on the whole machine
+
+typedef struct envBatch
+{
+	int numberEnvs;
+	int level;
+	int winWidth;
+	int winHeight;
+	int repeat; //game steps per env step, the action is held for all of them
+	gameState* games; //all the games next to each other
+	unsigned int* seeds; //seed of the next game of every env
+	int* blocksLeft; //to compute the rewards
+	threadPool* pool; //NULL steps all the envs on the calling thread
+	/* the current step, for the workers */
+	const int* actions;
+	float* observations;
+	float* rewards;
+	unsigned char* dones;
+	/* the current envRender */
+	unsigned char* frames;
+	int frameWidth;
+	int frameHeight;
+	rasterFormat frameFormat;
+} envBatch;
+
+envBatch* envCreate(int level, int winWidth, int winHeight, threadPool* pool);
+void envReset(envBatch* e, int numberEnvs, const unsigned int* seeds, float* observations); // observations: numberEnvs * ENV_OBSERVATION_SIZE
+/* actions are -1, 0 or 1 for every env. The reward is +1 for every destroyed block and -1 for a lost life,
+   a finished game is reported as done and replaced by a new one straight away, like going back to the menu */
+void envStep(envBatch* e, const int* actions, float* observations, float* rewards, unsigned char* dones);
+// pictures of all the games (see raster.h), one after the other: frames holds numberEnvs * rasterFrameSize(width, height, format) bytes
+void envRender(envBatch* e, unsigned char* frames, int width, int height, rasterFormat format);
+void envDestroy(envBatch* e);
+
+#endif
@@ -0,0 +1,247 @@
+// the physics of the deterministic build (GAME_FIXED, see fixed.h): the same routines as in game.c, on integers
+
+#include "game.h"
+#include "simd.h"
+#include <limits.h>
+#include <stdlib.h>
+
+#ifdef GAME_FIXED
+
+#define FIXED_NEVER LLONG_MAX //an entry time for a box the ball misses
+#define FIXED_BROADPHASE_MARGIN 1.0 //the broadphase is still in floats, a bigger box makes sure it never misses a block the integer sweep would hit
+
+char powerupXpaddle(powerup* pow, paddle* p) { //collision detection
+	fixed x = TO_FIXED(pow->x), y = TO_FIXED(pow->y), px = TO_FIXED(p->x), py = TO_FIXED(p->y);
+	fixed halfWidth = TO_FIXED(p->width) / 2, halfHeight = TO_FIXED(p->height) / 2;
+	return y <= py + halfHeight && y >= py - halfHeight && x >= px - halfWidth && x <= px + halfWidth;
+}
+
+bool updatePowerup(powerup* pow, paddle* p, double f) {
+	bool caught = powerupXpaddle(pow, p) != 0;
+	pow->y = FROM_FIXED(TO_FIXED(pow->y) + FIXED_MUL(TO_FIXED(pow->speed), TO_FIXED(f)));
+	return caught;
+}
+
+void updatePaddle(paddle* p, double f, int d, int w)
+{
+	fixed x = TO_FIXED(p->x) + FIXED_MUL(TO_FIXED(p->speed), TO_FIXED(f)) * d;
+	fixed halfWidth = TO_FIXED(p->width) / 2, wall = (fixed)(w / 2) * FIXED_ONE;
+	if (x + halfWidth >= wall) x = wall - halfWidth;
+	if (x - halfWidth <= -wall) x = -wall + halfWidth;
+	p->x = FROM_FIXED(x);
+}
+
+void updatePaddleTowards(paddle* p, double f, double x, int w)
+{
+	fixed ff = TO_FIXED(f), part = FIXED_MUL(ff, TO_FIXED(PADDLE_POINTER_GAIN));
+	if (part > FIXED_ONE) part = FIXED_ONE;
+	fixed move = FIXED_MUL(TO_FIXED(x) - TO_FIXED(p->x), part), most = FIXED_MUL(TO_FIXED(p->speed), ff);
+	if (move > most) move = most;
+	if (move < -most) move = -most;
+	p->x = FROM_FIXED(TO_FIXED(p->x) + move);
+	updatePaddle(p, 0.0, 0, w);
+}
+
+char ballXpaddle(ball* b, paddle* p)
+{
+	fixed x = TO_FIXED(b->x), y = TO_FIXED(b->y), px = TO_FIXED(p->x), py = TO_FIXED(p->y);
+	fixed halfWidth = TO_FIXED(p->width) / 2, halfHeight = TO_FIXED(p->height) / 2;
+	return y <= py + halfHeight && y >= py - halfHeight && x >= px - halfWidth && x <= px + halfWidth;
+}
+
+char ballXblock(ball* b, blockField* f, int i)
+{
+	fixed x = TO_FIXED(b->x), y = TO_FIXED(b->y), r = TO_FIXED(b->radius);
+	fixed bx = TO_FIXED(f->x[i]), by = TO_FIXED(f->y[i]), halfWidth = TO_FIXED(f->halfWidth[i]), halfHeight = TO_FIXED(f->halfHeight[i]);
+	return BLOCK_ALIVE(f, i) && y - r <= by + halfHeight && y + r >= by - halfHeight && x + r >= bx - halfWidth && x - r <= bx + halfWidth;
+}
+
+/* like sweepBox, with t as a fixed point fraction of the path: 0 to FIXED_ONE */
+static bool sweepFixed(fixed x, fixed y, fixed dx, fixed dy, fixed minX, fixed minY, fixed maxX, fixed maxY, fixed* t, int* axis)
+{
+	fixed enterX, exitX, enterY, exitY;
+	if (dx == 0) {
+		if (x <= minX || x >= maxX) return false;
+		enterX = LLONG_MIN;
+		exitX = LLONG_MAX;
+	}
+	else {
+		fixed t1 = FIXED_DIV(minX - x, dx), t2 = FIXED_DIV(maxX - x, dx);
+		enterX = t1 < t2 ? t1 : t2;
+		exitX = t1 < t2 ? t2 : t1;
+	}
+	if (dy == 0) {
+		if (y <= minY || y >= maxY) return false;
+		enterY = LLONG_MIN;
+		exitY = LLONG_MAX;
+	}
+	else {
+		fixed t1 = FIXED_DIV(minY - y, dy), t2 = FIXED_DIV(maxY - y, dy);
+		enterY = t1 < t2 ? t1 : t2;
+		exitY = t1 < t2 ? t2 : t1;
+	}
+	fixed enter = enterX > enterY ? enterX : enterY;
+	if (enter > (exitX < exitY ? exitX : exitY) || enter < 0 || enter > FIXED_ONE) return false;
+	*t = enter;
+	*axis = enterX > enterY ? 0 : 1;
+	return true;
+}
+
+/* the same test without a divide or a branch, so the loop over the candidates vectorizes (see sweepBlocks): an entry time e / |dx| on x and
+   one f / |dy| on y are compared as e * |dy| against f * |dx|, so the time it returns is over |dx| * |dy| (a zero
+   speed counts as 1), the same for every box of the path. The products fit in 64 bits for 16.16 screen coordinates.
+   FIXED_NEVER if the ball misses the box */
+static inline fixed sweepEnter(fixed x, fixed y, fixed dx, fixed dy, fixed scaleX, fixed scaleY, fixed minX, fixed minY, fixed maxX, fixed maxY)
+{
+	fixed flipX = -(fixed)(dx < 0), flipY = -(fixed)(dy < 0), movingX = -(fixed)(dx != 0), movingY = -(fixed)(dy != 0); //masks, a ?: on them makes a copy of the loop for every sign
+	fixed nearX = ((((minX & ~flipX) | (maxX & flipX)) - x) ^ flipX) - flipX, farX = ((((maxX & ~flipX) | (minX & flipX)) - x) ^ flipX) - flipX;
+	fixed nearY = ((((minY & ~flipY) | (maxY & flipY)) - y) ^ flipY) - flipY, farY = ((((maxY & ~flipY) | (minY & flipY)) - y) ^ flipY) - flipY;
+	fixed outside = (~movingX & -(fixed)((nearX >= 0) | (farX <= 0))) | (~movingY & -(fixed)((nearY >= 0) | (farY <= 0))); //not moving on an axis and out of its slab
+	fixed enterX = (nearX * scaleY & movingX) | (LLONG_MIN & ~movingX), exitX = (farX * scaleY & movingX) | (LLONG_MAX & ~movingX);
+	fixed enterY = (nearY * scaleX & movingY) | (LLONG_MIN & ~movingY), exitY = (farY * scaleX & movingY) | (LLONG_MAX & ~movingY);
+	fixed in = enterX > enterY ? enterX : enterY, out = exitX < exitY ? exitX : exitY;
+	return (in <= out) & (in >= 0) & (in <= scaleX * scaleY) & (outside == 0) ? in : FIXED_NEVER;
+}
+
+/* the soonest entry of up to 256 candidate blocks, and in lowest the lowest index that enters then. Every loop is
+   branch free, but 64 bit lanes need AVX2 for the multiplies and compares, so the plain x86 target runs it scalar */
+static SIMD_INLINE fixed sweepBlocks(fixed x, fixed y, fixed dx, fixed dy, fixed r, const blockField* f, const int* candidates, int count, int* lowest)
+{
+	fixed minX[256], minY[256], maxX[256], maxY[256], enter[256];
+	fixed scaleX = dx == 0 ? 1 : llabs(dx), scaleY = dy == 0 ? 1 : llabs(dy);
+	for (int k = 0; k < count; k++) { //the boxes grown by the radius, gathered into one array per side
+		int i = candidates[k];
+		minX[k] = f->fixedMinX[i] - r;
+		minY[k] = f->fixedMinY[i] - r;
+		maxX[k] = f->fixedMaxX[i] + r;
+		maxY[k] = f->fixedMaxY[i] + r;
+	}
+	for (int k = 0; k < count; k++) enter[k] = sweepEnter(x, y, dx, dy, scaleX, scaleY, minX[k], minY[k], maxX[k], maxY[k]);
+	fixed soonest = FIXED_NEVER;
+	for (int k = 0; k < count; k++) soonest = enter[k] < soonest ? enter[k] : soonest;
+	fixed index = INT_MAX; //at the same time the lowest index wins, whatever order the grid gave them in. 64 bits wide like enter or it does not vectorize
+	for (int k = 0; k < count; k++) {
+		fixed i = enter[k] == soonest ? candidates[k] : INT_MAX;
+		index = i < index ? i : index;
+	}
+	*lowest = (int)index;
+	return soonest;
+}
+
+static fixed sweepBlocksPlain(fixed x, fixed y, fixed dx, fixed dy, fixed r, const blockField* f, const int* candidates, int count, int* lowest) {
+	return sweepBlocks(x, y, dx, dy, r, f, candidates, count, lowest);
+}
+
+#ifdef SIMD_X86
+TARGET_AVX2 static fixed sweepBlocksAvx2(fixed x, fixed y, fixed dx, fixed dy, fixed r, const blockField* f, const int* candidates, int count, int* lowest) {
+	return sweepBlocks(x, y, dx, dy, r, f, candidates, count, lowest);
+}
+#else
+#define sweepBlocksAvx2 sweepBlocksPlain //the kernel is never 2 without x86
+#endif
+
+bool sweepBox(double x, double y, double dx, double dy, double minX, double minY, double maxX, double maxY, double* t, int* axis)
+{
+	fixed tt;
+	if (!sweepFixed(TO_FIXED(x), TO_FIXED(y), TO_FIXED(dx), TO_FIXED(dy), TO_FIXED(minX), TO_FIXED(minY), TO_FIXED(maxX), TO_FIXED(maxY), &tt, axis)) return false;
+	*t = FROM_FIXED(tt);
+	return true;
+}
+
+void updateBall(ball* b, double f, paddle* p1, blockField* bl1, blockGrid* grid, int w, int h, double cameraY, ballResult* result, candidateBuffer* buffer)
+{
+	fixed x = TO_FIXED(b->x), y = TO_FIXED(b->y), r = TO_FIXED(b->radius), sx = TO_FIXED(b->speedX), sy = TO_FIXED(b->speedY);
+	fixed remaining = TO_FIXED(f);
+	fixed camera = TO_FIXED(cameraY);
+	fixed left = -(fixed)(w / 2) * FIXED_ONE + r, right = (fixed)(w / 2) * FIXED_ONE - r;
+	fixed top = camera + (fixed)(h / 2) * FIXED_ONE - r, bottom = camera - (fixed)(h / 2) * FIXED_ONE + r;
+	fixed px = TO_FIXED(p1->x), py = TO_FIXED(p1->y), paddleHalfWidth = TO_FIXED(p1->width) / 2, paddleHalfHeight = TO_FIXED(p1->height) / 2;
+	fixed turn = (fixed)((int)p1->width / 2) * FIXED_ONE; //changeSpeed works on the width in whole pixels
+	result->numberHits = 0;
+	result->lost = false;
+	result->paddleHit = false;
+	result->tests = 0;
+	for (int impacts = 0; impacts < BALL_MAX_IMPACTS && remaining > 0; impacts++) {
+		fixed dx = FIXED_MUL(sx, remaining), dy = FIXED_MUL(sy, remaining);
+		fixed t = FIXED_ONE;
+		int axis = 0;
+		int what = IMPACT_NONE;
+		int index = -1;
+		fixed tt;
+		int ax;
+
+		if (dx < 0 && (tt = FIXED_DIV(left - x, dx)) < t) { t = tt > 0 ? tt : 0; axis = 0; what = IMPACT_WALL; }
+		if (dx > 0 && (tt = FIXED_DIV(right - x, dx)) < t) { t = tt > 0 ? tt : 0; axis = 0; what = IMPACT_WALL; }
+		if (dy > 0 && (tt = FIXED_DIV(top - y, dy)) < t) { t = tt > 0 ? tt : 0; axis = 1; what = IMPACT_WALL; }
+		if (dy < 0 && (tt = FIXED_DIV(bottom - y, dy)) < t) { t = tt > 0 ? tt : 0; axis = 1; what = IMPACT_BOTTOM; }
+
+		if (sweepFixed(x, y, dx, dy, px - paddleHalfWidth - r, py - paddleHalfHeight - r, px + paddleHalfWidth + r, py + paddleHalfHeight + r, &tt, &ax) && tt < t) {
+			t = tt; axis = ax; what = IMPACT_PADDLE;
+		}
+
+		int nearby[256];
+		int* candidates = nearby;
+		double boxMinX = FROM_FIXED((dx < 0 ? x + dx : x) - r) - FIXED_BROADPHASE_MARGIN, boxMinY = FROM_FIXED((dy < 0 ? y + dy : y) - r) - FIXED_BROADPHASE_MARGIN;
+		double boxMaxX = FROM_FIXED((dx > 0 ? x + dx : x) + r) + FIXED_BROADPHASE_MARGIN, boxMaxY = FROM_FIXED((dy > 0 ? y + dy : y) + r) + FIXED_BROADPHASE_MARGIN;
+		int n = nearbyBlocks(bl1, grid, boxMinX, boxMinY, boxMaxX, boxMaxY, nearby, 256);
+		if (n > 256) candidates = moreCandidates(bl1, grid, boxMinX, boxMinY, boxMaxX, boxMaxY, n, buffer);
+		if (candidates == NULL) {
+			candidates = nearby;
+			n = 256;
+		}
+		result->tests += n + 1;
+		fixed scaleX = dx == 0 ? 1 : llabs(dx), scaleY = dy == 0 ? 1 : llabs(dy); //what the entry times of sweepEnter are over
+		fixed best = FIXED_NEVER;
+		int block = INT_MAX;
+		for (int first = 0; first < n; first += 256) { //256 boxes at a time, a long path may have more candidates
+			int count = n - first < 256 ? n - first : 256, lowest;
+			fixed soonest = bl1->kernel == 2 ? sweepBlocksAvx2(x, y, dx, dy, r, bl1, candidates + first, count, &lowest) :
+				sweepBlocksPlain(x, y, dx, dy, r, bl1, candidates + first, count, &lowest);
+			if (soonest == FIXED_NEVER || soonest > best) continue;
+			if (soonest < best || lowest < block) block = lowest;
+			best = soonest;
+		}
+		if (best != FIXED_NEVER) { //only the winner is divided
+			fixed enterX = dx < 0 ? x - bl1->fixedMaxX[block] - r : bl1->fixedMinX[block] - r - x;
+			fixed enterY = dy < 0 ? y - bl1->fixedMaxY[block] - r : bl1->fixedMinY[block] - r - y;
+			ax = dx != 0 && (dy == 0 || enterX * scaleY > enterY * scaleX) ? 0 : 1;
+			tt = ax == 0 ? FIXED_DIV(enterX, scaleX) : FIXED_DIV(enterY, scaleY);
+			if (tt < t) {
+				t = tt; axis = ax; what = IMPACT_BLOCK; index = block;
+			}
+		}
+
+		x += FIXED_MUL(t, dx);
+		y += FIXED_MUL(t, dy);
+		remaining -= FIXED_MUL(t, remaining);
+
+		if (what == IMPACT_BOTTOM) {
+			result->lost = true;
+			break;
+		}
+		else if (what == IMPACT_PADDLE) {
+			result->paddleHit = true;
+			if (axis == 1 && sy < 0) { //on top of the paddle, the cases of changeSpeed
+				if (sx > 0 ? x >= px - turn && x < px : x <= px + turn && x > px) sx = -sx;
+				sy = -sy;
+			}
+			else if (axis == 1) sy = -sy;
+			else sx = -sx;
+		}
+		else if (what == IMPACT_BLOCK) {
+			result->hits[result->numberHits++] = index;
+			if (axis == 0) sx = -sx;
+			else sy = -sy;
+		}
+		else if (what == IMPACT_WALL) {
+			if (axis == 0) sx = -sx;
+			else sy = -sy;
+		}
+	}
+	b->x = FROM_FIXED(x);
+	b->y = FROM_FIXED(y);
+	b->speedX = FROM_FIXED(sx);
+	b->speedY = FROM_FIXED(sy);
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+// the deterministic build: compiled with GAME_FIXED defined (make headless_fixed, or add it to the preprocessor
+// definitions in Visual Studio) the physics runs on 16.16 fixed point numbers in 64 bit integers instead of doubles.
+// The game state keeps its doubles, but in this build they only ever hold numbers on the 1/65536 grid, which a double
+// stores exactly, so converting them back and forth loses nothing. Integer maths does not depend on the compiler,
+// the optimisation level, FMA contraction or x87 against SSE, so a replay or a lockstep game gives the same bits everywhere
+
+#include <math.h>
+
+typedef long long fixed;
+
+#define FIXED_ONE 65536LL
+#define TO_FIXED(v) ((fixed)floor((v) * 65536.0 + 0.5)) // nearest on the grid, exact for a number that is already on it
+#define FROM_FIXED(v) ((double)(v) / 65536.0)
+#define FIXED_MUL(a, b) (((a) * (b)) >> 16) // the products stay far below 2^63 for anything on the screen
+#define FIXED_DIV(a, b) (((a) * FIXED_ONE) / (b))
+#define FIXED_COS25 59396LL // cos and sin of 25 degrees for the multiball, not computed so no libm is involved
+#define FIXED_SIN25 27697LL
+
+#ifdef GAME_FIXED
+#define GAME_FIXED_POINT 1
+#else
+#define GAME_FIXED_POINT 0
+#endif
+
+#endif
@@ -0,0 +1,577 @@
+// the simulation core of the game, shared by the SDL game (main.c) and the headless driver (headless.c)
+
+#include "game.h"
+#include "stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+void initializePaddle(paddle* p, double x, double y, double w, double h, double sp)
+{
+	p->x = x;
+	p->y = y;
+	p->width = w;
+	p->height = h;
+	p->speed = sp;
+	p->lives = 3;
+}
+
+powerup initializePowerup(double x, double y, powerupType type)
+{
+	powerup pow;
+	pow.type = type;
+	pow.x = x;
+	pow.y = y;
+	pow.radius = 5;
+	pow.speed = -60; //powerup falls towards the bottom
+	return pow;
+}
+
+void initializeBall(ball* b, double x, double y, double r, double sx, double sy)
+{
+	b->x = x;
+	b->y = y;
+	b->radius = r;
+	b->speedX = sx;
+	b->speedY = sy;
+}
+
+#ifndef GAME_FIXED //the fixed point versions of the physics are in fixed.c
+char powerupXpaddle(powerup* pow, paddle* p) { //collision detection
+	return (pow->y <= p->y + (p->height / 2.0)) &&
+		(pow->y >= p->y - (p->height / 2.0)) &&
+		(pow->x >= p->x - (p->width / 2.0)) &&
+		(pow->x <= p->x + (p->width / 2.0));
+}
+
+bool updatePowerup(powerup* pow, paddle* p, double f) {
+	bool caught = powerupXpaddle(pow, p) != 0; // the powerup falls and if its touched by the paddle the player gets its bonus
+	pow->y += pow->speed * f;
+	return caught;
+}
+
+void updatePaddle(paddle* p, double f, int d, int w)
+{
+	p->x += p->speed * f * (double)d; /* calculate next position */
+
+	/* ensure the paddle does not go beyond the boundaries */
+	if (p->x + (p->width / 2.0) >= (double)(w / 2)) p->x = (double)(w / 2) - (p->width / 2.0);
+	if (p->x - (p->width / 2.0) <= (double)(w / -2)) p->x = (double)(w / -2) + (p->width / 2.0);
+}
+
+void updatePaddleTowards(paddle* p, double f, double x, int w)
+{
+	double part = f * PADDLE_POINTER_GAIN < 1.0 ? f * PADDLE_POINTER_GAIN : 1.0;
+	double move = (x - p->x) * part, most = p->speed * f;
+	if (move > most) move = most;
+	if (move < -most) move = -most;
+	p->x += move;
+	updatePaddle(p, 0.0, 0, w); //only the boundaries
+}
+
+char ballXpaddle(ball* b, paddle* p) /* collision detection */
+{ 	/* return if the ball has collided with the paddle */
+	return (b->y <= p->y + (p->height / 2.0)) &&
+		(b->y >= p->y - (p->height / 2.0)) &&
+		(b->x >= p->x - (p->width / 2.0)) &&
+		(b->x <= p->x + (p->width / 2.0)); /* ball y matches the paddle */
+}
+
+char ballXblock(ball* b, blockField* f, int i) /* collision detection */
+{   /* return if the ball has collided with the block*/
+	return BLOCK_ALIVE(f, i) &&
+		(b->y - b->radius <= f->y[i] + f->halfHeight[i]) &&
+		(b->y + b->radius >= f->y[i] - f->halfHeight[i]) &&
+		(b->x + b->radius >= f->x[i] - f->halfWidth[i]) &&
+		(b->x - b->radius <= f->x[i] + f->halfWidth[i]);
+}
+#endif
+
+
+//source from "Davide Bressani" starts here
+void changeSpeed(ball* b, paddle* p) { // the ball changes direction based on how it hits the paddle to make it seem more natural, there are 4 cases
+	int width = p->width;
+	if (b->speedX > 0) {
+		if (b->x >= p->x - width / 2 && b->x < p->x) { // 1st case: if the ball arrives from the left and hits the left side of the paddle it bounces back
+			b->speedX *= -1;
+		}
+	}
+	else {
+		if (b->x <= p->x + width / 2 && b->x > p->x) { // 2nd case: if the ball arrives from the right and hits the right side of the paddle it bounces back
+			b->speedX *= -1;
+		}
+	}
+	b->speedY *= -1.0; //in every case the speedY is negative so it bounces back, in the 3rd and 4th case the ball continues travelling with the same speedX
+}
+//source from "Davide Bressani" ends here
+#ifndef GAME_FIXED
+/* swept collision: instead of checking overlaps after the ball has moved, the ball travels along its path
+   and stops at the first thing it would touch, bounces, and carries on with the time that is left */
+
+bool sweepBox(double x, double y, double dx, double dy, double minX, double minY, double maxX, double maxY, double* t, int* axis)
+{ /* when does the point (x,y) moving by (dx,dy) enter the box? t goes from 0 to 1, axis is 0 for a side and 1 for top/bottom */
+	double enterX, exitX, enterY, exitY;
+	if (dx == 0.0) {
+		if (x <= minX || x >= maxX) return false;
+		enterX = -INFINITY;
+		exitX = INFINITY;
+	}
+	else {
+		double t1 = (minX - x) / dx, t2 = (maxX - x) / dx;
+		enterX = fmin(t1, t2);
+		exitX = fmax(t1, t2);
+	}
+	if (dy == 0.0) {
+		if (y <= minY || y >= maxY) return false;
+		enterY = -INFINITY;
+		exitY = INFINITY;
+	}
+	else {
+		double t1 = (minY - y) / dy, t2 = (maxY - y) / dy;
+		enterY = fmin(t1, t2);
+		exitY = fmax(t1, t2);
+	}
+	double enter = fmax(enterX, enterY);
+	if (enter > fmin(exitX, exitY) || enter < 0.0 || enter > 1.0) return false; //misses, is already inside, or is too far
+	*t = enter;
+	*axis = enterX > enterY ? 0 : 1;
+	return true;
+}
+#endif
+
+int nearbyBlocks(blockField* f, blockGrid* grid, double minX, double minY, double maxX, double maxY, int* out, int max)
+{ /* alive blocks overlapping the box: small levels are scanned 8 blocks at a time, big ones go through the grid */
+	if (f->count > BLOCKS_SCAN_MAX) return gridQuery(grid, f, minX, minY, maxX, maxY, out, max);
+	int found = 0;
+	for (int i = blockFieldFirstOverlap(f, (float)minX, (float)minY, (float)maxX, (float)maxY, 0); i >= 0;
+		i = blockFieldFirstOverlap(f, (float)minX, (float)minY, (float)maxX, (float)maxY, i + 1)) {
+		if (found < max) out[found] = i;
+		found++;
+	}
+	return found;
+}
+
+int* moreCandidates(blockField* f, blockGrid* grid, double minX, double minY, double maxX, double maxY, int n, candidateBuffer* buffer)
+{ /* a very long path found more blocks than updateBall keeps on the stack. They come in grid order, not along the path,
+     so none can be left out: they go in the buffer of the worker, which keeps its size for the next long path */
+	if (n > buffer->capacity) {
+		int capacity = buffer->capacity > 0 ? buffer->capacity : 1024;
+		while (capacity < n) capacity *= 2;
+		int* blocks = realloc(buffer->blocks, capacity * sizeof(int));
+		if (blocks == NULL) return NULL;
+		buffer->blocks = blocks;
+		buffer->capacity = capacity;
+	}
+	nearbyBlocks(f, grid, minX, minY, maxX, maxY, buffer->blocks, n);
+	return buffer->blocks;
+}
+
+#ifndef GAME_FIXED
+void updateBall(ball* b, double f, paddle* p1, blockField* bl1, blockGrid* grid, int w, int h, double cameraY, ballResult* result, candidateBuffer* buffer)
+{
+	double remaining = f;
+	result->numberHits = 0;
+	result->lost = false;
+	result->paddleHit = false;
+	result->tests = 0;
+	for (int impacts = 0; impacts < BALL_MAX_IMPACTS && remaining > 0.0; impacts++) {
+		double dx = b->speedX * remaining, dy = b->speedY * remaining;
+		double t = 1.0; //the first impact along the path, as a fraction of the remaining time
+		int axis = 0;
+		int what = IMPACT_NONE;
+		int index = -1;
+		double tt;
+		int ax;
+
+		/* scene boundaries, the ball centre can move between them. The top and bottom follow the window */
+		if (dx < 0.0 && (tt = (-1.0 * (double)(w / 2) + b->radius - b->x) / dx) < t) { t = fmax(tt, 0.0); axis = 0; what = IMPACT_WALL; }
+		if (dx > 0.0 && (tt = ((double)(w / 2) - b->radius - b->x) / dx) < t) { t = fmax(tt, 0.0); axis = 0; what = IMPACT_WALL; }
+		if (dy > 0.0 && (tt = (cameraY + (double)(h / 2) - b->radius - b->y) / dy) < t) { t = fmax(tt, 0.0); axis = 1; what = IMPACT_WALL; }
+		if (dy < 0.0 && (tt = (cameraY - (double)(h / 2) + b->radius - b->y) / dy) < t) { t = fmax(tt, 0.0); axis = 1; what = IMPACT_BOTTOM; }
+
+		/* the paddle and the blocks are grown by the radius of the ball, so the ball can be treated as a point */
+		if (sweepBox(b->x, b->y, dx, dy, p1->x - p1->width / 2.0 - b->radius, p1->y - p1->height / 2.0 - b->radius,
+			p1->x + p1->width / 2.0 + b->radius, p1->y + p1->height / 2.0 + b->radius, &tt, &ax) && tt < t) {
+			t = tt; axis = ax; what = IMPACT_PADDLE;
+		}
+
+		int nearby[256];
+		int* candidates = nearby;
+		double boxMinX = fmin(b->x, b->x + dx) - b->radius, boxMinY = fmin(b->y, b->y + dy) - b->radius;
+		double boxMaxX = fmax(b->x, b->x + dx) + b->radius, boxMaxY = fmax(b->y, b->y + dy) + b->radius;
+		int n = nearbyBlocks(bl1, grid, boxMinX, boxMinY, boxMaxX, boxMaxY, nearby, 256);
+		if (n > 256) candidates = moreCandidates(bl1, grid, boxMinX, boxMinY, boxMaxX, boxMaxY, n, buffer);
+		if (candidates == NULL) { //out of memory, only then the first blocks found are all that is checked
+			candidates = nearby;
+			n = 256;
+		}
+		result->tests += n + 1;
+		for (int k = 0; k < n; k++) {
+			int i = candidates[k];
+			if (sweepBox(b->x, b->y, dx, dy, bl1->x[i] - bl1->halfWidth[i] - b->radius, bl1->y[i] - bl1->halfHeight[i] - b->radius,
+				bl1->x[i] + bl1->halfWidth[i] + b->radius, bl1->y[i] + bl1->halfHeight[i] + b->radius, &tt, &ax) &&
+				(tt < t || (tt == t && what == IMPACT_BLOCK && i < index))) { //same time: the lowest index wins, like the old loop
+				t = tt; axis = ax; what = IMPACT_BLOCK; index = i;
+			}
+		}
+
+		/* move up to the impact */
+		b->x += t * dx;
+		b->y += t * dy;
+		remaining -= t * remaining;
+
+		if (what == IMPACT_BOTTOM) { //the ball is out, gameStep decides if a life is lost
+			result->lost = true;
+			return;
+		}
+		else if (what == IMPACT_PADDLE) {
+			result->paddleHit = true;
+			if (axis == 1 && b->speedY < 0.0) changeSpeed(b, p1); //on top of the paddle
+			else if (axis == 1) b->speedY *= -1.0;
+			else b->speedX *= -1.0; //on the side of the paddle
+		}
+		else if (what == IMPACT_BLOCK) { //the damage is done later, when the hits of all the balls are merged
+			result->hits[result->numberHits++] = index;
+			if (axis == 0) b->speedX *= -1.0; //the side of the block
+			else b->speedY *= -1.0; //the bottom or top of the block
+		}
+		else if (what == IMPACT_WALL) {
+			if (axis == 0) b->speedX *= -1.0;
+			else b->speedY *= -1.0;
+		}
+	}
+}
+#endif
+
+void randomSeed(unsigned long long* rng, unsigned int seed) { //splitmix64, so close seeds still give very different states
+	unsigned long long z = (unsigned long long)seed + 0x9e3779b97f4a7c15ull;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	*rng = (z ^ (z >> 31)) | 1; //xorshift never leaves 0
+}
+
+unsigned int randomNext(unsigned long long* rng) { //xorshift64*
+	unsigned long long x = *rng;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*rng = x;
+	return (unsigned int)((x * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+int randomRange(unsigned long long* rng, int n) {
+	return (int)(((unsigned long long)randomNext(rng) * (unsigned int)n) >> 32);
+}
+
+void gameInit(gameState* s, int numberPowerups, int numberBlocks, int blocksRows, int winWidth, int winHeight, unsigned int seed) {
+	if (numberPowerups > numberBlocks) numberPowerups = numberBlocks;
+	randomSeed(&s->rng, seed);
+	s->seed = seed;
+	s->level = 0;
+	if (!gameReserve(s, numberBlocks, numberPowerups, false)) return;
+	blockFieldResize(&s->blocks, numberBlocks, &s->arena);
+	for (int r = 0; r < blocksRows; r++) { //the placing and spacing between the blocks
+		for (int c = 0; c < numberBlocks/blocksRows; c++) {
+			int spacing = 8;
+
+			double blockWidth = (winWidth - (spacing * 9)) / 8;
+			double blockHeight = 30;
+			double x = (-winWidth / 2) + ((c + 1) * spacing + (c + 0.5) * blockWidth);
+			double y = (winHeight / 2) - (32 + (r + 0.5) * blockHeight + r * spacing);
+			int index = (r * numberBlocks / blocksRows) + c;
+
+			blockFieldSet(&s->blocks, index, x, y, blockWidth, blockHeight, r+1);
+		}
+	}
+
+	gamePlacePowerups(s, numberPowerups);
+	gridBuild(&s->grid, &s->blocks, 0.0);
+	gameStart(s, winWidth, winHeight);
+}
+
+bool gameReserveBalls(gameState* s, int count) {
+	if (count <= s->capacityBalls) return true;
+	if (count > BALLS_MAX) return false;
+	int capacity = s->capacityBalls > 0 ? s->capacityBalls : 1;
+	while (capacity < count) capacity *= 2;
+	if (capacity > BALLS_MAX) capacity = BALLS_MAX;
+	ball* balls = realloc(s->balls, capacity * sizeof(ball));
+	if (balls == NULL) return false; //the old pool is still there, the new ball is just not added
+	s->balls = balls;
+	ballResult* results = realloc(s->ballResults, capacity * sizeof(ballResult));
+	if (results == NULL) return false;
+	s->ballResults = results;
+	s->capacityBalls = capacity;
+	return true;
+}
+
+bool gameReserve(gameState* s, int numberBlocks, int numberPowerups, bool mappedBlocks) {
+	streamDestroy(s->stream); //a new level, the old one may have been streamed
+	s->stream = NULL;
+	s->numberBalls = 0;
+	int first = 1 + (s->extraBalls > 0 ? s->extraBalls : 0), balls = first < BALLS_MAX ? first : BALLS_MAX;
+	for (int i = 0; i < numberPowerups && balls < BALLS_RESERVE; i++) balls *= 3; //as if every powerup was a multiball, up to a point
+	if (balls > BALLS_RESERVE && balls > first) balls = BALLS_RESERVE;
+	gameReserveBalls(s, balls);
+	size_t size = blockFieldArenaSize(numberBlocks, mappedBlocks) + arenaRound(numberBlocks) + arenaRound(numberPowerups * sizeof(powerup));
+	size += arenaRound(numberBlocks * sizeof(int)); //scratch for gamePlacePowerups to draw the powerup blocks
+	arenaReserve(&s->arena, size);
+
+	s->blockPowerups = arenaAlloc(&s->arena, numberBlocks);
+	s->powerups = arenaAlloc(&s->arena, numberPowerups * sizeof(powerup)); //every powerup falls once at most
+	s->numberPowerups = 0;
+	s->capacityPowerups = numberPowerups;
+	if (s->blockPowerups == NULL || s->powerups == NULL || s->capacityBalls == 0) { //out of memory: an empty level that is already lost
+		arenaReserve(&s->arena, 0);
+		blockFieldFree(&s->blocks);
+		gridFree(&s->grid);
+		s->blockPowerups = NULL;
+		s->powerups = NULL;
+		s->capacityPowerups = 0;
+		s->status = GAME_LOST;
+		return false;
+	}
+	memset(s->blockPowerups, 0, numberBlocks);
+	return true;
+}
+
+void gameAddPowerup(gameState* s, int block, powerupType type) {
+	s->blockPowerups[block] = (unsigned char)(type + 1);
+}
+
+void gamePlacePowerups(gameState* s, int count) {
+	/* the powerups go in the first count blocks of a partial Fisher-Yates shuffle of the blocks without one, so no block gets two */
+	size_t mark = arenaMark(&s->arena);
+	int* order = arenaAlloc(&s->arena, s->blocks.count * sizeof(int));
+	int n = 0;
+	for (int i = 0; i < s->blocks.count; i++) if (s->blockPowerups[i] == 0) order[n++] = i;
+	if (count > n) count = n;
+	for (int i = 0; i < count; i++) {
+		int j = i + randomRange(&s->rng, n - i);
+		int block = order[j];
+		order[j] = order[i];
+		order[i] = block;
+		gameAddPowerup(s, block, (powerupType)randomRange(&s->rng, POWERUP_TYPES));
+	}
+	arenaRewind(&s->arena, mark);
+}
+
+void gameBlockChanged(gameState* s, int block) {
+	if (s->numberChanged < BLOCKS_CHANGED_MAX) s->changedBlocks[s->numberChanged] = block;
+	if (s->numberChanged <= BLOCKS_CHANGED_MAX) s->numberChanged++; //it stops one over, meaning too many
+}
+
+static void addEvent(gameState* s, gameEventType type, double x, double y, int detail) {
+	if (s->numberEvents == GAME_EVENTS_MAX) return;
+	gameEvent* e = &s->events[s->numberEvents++];
+	e->type = type;
+	e->x = (float)x;
+	e->y = (float)y;
+	e->detail = detail;
+}
+
+static void dropPowerup(gameState* s, int block) { //the block is destroyed, its powerup starts falling
+	if (s->numberPowerups == s->capacityPowerups) return;
+	s->powerups[s->numberPowerups++] = initializePowerup(s->blocks.x[block], s->blocks.y[block], (powerupType)(s->blockPowerups[block] - 1));
+	s->blockPowerups[block] = 0;
+}
+
+void gameStart(gameState* s, int winWidth, int winHeight) {
+	s->numberChanged = BLOCKS_CHANGED_MAX + 1; //a new level, everything has to be drawn
+	s->numberEvents = 0;
+	s->score = 0;
+	s->winWidth = winWidth;
+	s->winHeight = winHeight;
+	s->cameraY = 0.0;
+	s->status = GAME_PLAYING;
+
+	/* initialize objects */
+	s->numberBalls = 0;
+	gameSpawnBall(s, 0.0, 0.0, 60.0, 200.0);
+	initializePaddle(&s->paddle, 0.0, -200.0, 40, 6, 150.0);
+}
+
+void gameFree(gameState* s) {
+	streamDestroy(s->stream);
+	s->stream = NULL;
+	gridFree(&s->grid);
+	blockFieldFree(&s->blocks);
+	arenaFree(&s->arena); //the powerups were in it
+	free(s->balls);
+	free(s->ballResults);
+	for (int i = 0; i < THREADS_MAX; i++) free(s->candidates[i].blocks);
+	memset(s->candidates, 0, sizeof(s->candidates));
+	s->balls = NULL;
+	s->ballResults = NULL;
+	s->powerups = NULL;
+	s->blockPowerups = NULL;
+	s->numberBalls = s->capacityBalls = 0;
+	s->numberPowerups = s->capacityPowerups = 0;
+}
+
+ball* gameSpawnBall(gameState* s, double x, double y, double sx, double sy) {
+	if (s->numberBalls >= s->capacityBalls && !gameReserveBalls(s, s->numberBalls + 1)) return NULL; //the pool grows when a multiball needs it
+	ball* b = &s->balls[s->numberBalls++];
+	initializeBall(b, x, y, 5.0, sx, sy);
+	return b;
+}
+
+void splitBalls(gameState* s) { //every ball gets two copies going 25 degrees to its sides
+	int n = s->numberBalls;
+#ifdef GAME_FIXED
+	for (int i = 0; i < n; i++) {
+		ball b = s->balls[i];
+		fixed x = TO_FIXED(b.speedX), y = TO_FIXED(b.speedY);
+		gameSpawnBall(s, b.x, b.y, FROM_FIXED(FIXED_MUL(x, FIXED_COS25) - FIXED_MUL(y, FIXED_SIN25)), FROM_FIXED(FIXED_MUL(x, FIXED_SIN25) + FIXED_MUL(y, FIXED_COS25)));
+		gameSpawnBall(s, b.x, b.y, FROM_FIXED(FIXED_MUL(x, FIXED_COS25) + FIXED_MUL(y, FIXED_SIN25)), FROM_FIXED(FIXED_MUL(y, FIXED_COS25) - FIXED_MUL(x, FIXED_SIN25)));
+	}
+#else
+	double c = cos(25.0 * PI / 180.0), sn = sin(25.0 * PI / 180.0);
+	for (int i = 0; i < n; i++) {
+		ball b = s->balls[i];
+		gameSpawnBall(s, b.x, b.y, b.speedX * c - b.speedY * sn, b.speedX * sn + b.speedY * c);
+		gameSpawnBall(s, b.x, b.y, b.speedX * c + b.speedY * sn, -b.speedX * sn + b.speedY * c);
+	}
+#endif
+}
+
+static void powerupLife(gameState* s) { s->paddle.lives++; }
+static void powerupMultiball(gameState* s) { splitBalls(s); }
+static void powerupWide(gameState* s) { s->paddle.width = fmin(s->paddle.width + 10.0, PADDLE_WIDTH_MAX); }
+
+static void (*const powerupEffects[POWERUP_TYPES])(gameState* s) = { powerupLife, powerupMultiball, powerupWide }; //what catching every type does
+
+static unsigned int hashBytes(unsigned int h, const void* data, size_t size) { //FNV-1a
+	const unsigned char* p = data;
+	for (size_t i = 0; i < size; i++) h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+unsigned int gameChecksum(const gameState* s) {
+	unsigned int h = 2166136261u;
+	h = hashBytes(h, &s->paddle, sizeof(s->paddle));
+	h = hashBytes(h, &s->numberBalls, sizeof(s->numberBalls));
+	h = hashBytes(h, s->balls, s->numberBalls * sizeof(ball));
+	h = hashBytes(h, s->blocks.strength, s->blocks.count * sizeof(float));
+	h = hashBytes(h, s->blocks.alive, (s->blocks.count + 31) / 32 * sizeof(unsigned int));
+	h = hashBytes(h, &s->numberPowerups, sizeof(s->numberPowerups));
+	for (int i = 0; i < s->numberPowerups; i++) { //only the fields, the padding of the struct is not reliable
+		const powerup* pow = &s->powerups[i];
+		h = hashBytes(h, &pow->type, sizeof(pow->type));
+		h = hashBytes(h, &pow->x, sizeof(pow->x));
+		h = hashBytes(h, &pow->y, sizeof(pow->y));
+	}
+	h = hashBytes(h, &s->rng, sizeof(s->rng));
+	if (s->stream != NULL) h = hashBytes(h, &s->cameraY, sizeof(s->cameraY)); //so the replays of the other levels still match
+	h = hashBytes(h, &s->status, sizeof(s->status));
+	return h;
+}
+
+typedef struct ballJob
+{
+	gameState* s;
+	double dt;
+} ballJob;
+
+void updateBallsTask(void* data, int begin, int end, int worker) {
+	ballJob* job = data;
+	gameState* s = job->s;
+	int tests = 0;
+	PROFILE_BEGIN(zone, "balls");
+	for (int i = begin; i < end; i++) {
+		updateBall(&s->balls[i], job->dt, &s->paddle, &s->blocks, &s->grid, s->winWidth, s->winHeight, s->cameraY, &s->ballResults[i], &s->candidates[worker]);
+		tests += s->ballResults[i].tests;
+	}
+	PROFILE_COUNT(PROFILE_COLLISION_TESTS, tests);
+	PROFILE_END(zone);
+}
+
+void gameInitLevel(gameState* s, int level, int winWidth, int winHeight, unsigned int seed) {
+	static const int levels[LEVELS_NUMBER][3] = { {2, 24, 3}, {3, 32, 4}, {4, 40, 5} }; //powerups, blocks and rows of every level
+	if (level < 1) level = 1;
+	if (level > LEVELS_NUMBER) level = LEVELS_NUMBER;
+	gameInit(s, levels[level - 1][0], levels[level - 1][1], levels[level - 1][2], winWidth, winHeight, seed);
+	s->level = level;
+}
+
+static void movePaddle(gameState* s, const gameInput* in, double dt) { //piece by piece, every direction for the part of the step it was held
+	if (in->pointer) {
+		updatePaddleTowards(&s->paddle, dt, in->pointerX, s->winWidth);
+		return;
+	}
+	int dir = in->p1dir, from = 0;
+	for (int k = 0; k < in->numberChanges; k++) {
+		updatePaddle(&s->paddle, dt * (in->changeAt[k] - from) / INPUT_SUBSTEPS, dir, s->winWidth);
+		from = in->changeAt[k];
+		dir = in->changeDir[k];
+	}
+	updatePaddle(&s->paddle, dt * (INPUT_SUBSTEPS - from) / INPUT_SUBSTEPS, dir, s->winWidth); //all of dt when nothing changed
+}
+
+void gameStep(gameState* s, const gameInput* in, double dt) {
+	if (s->status != GAME_PLAYING) return;
+	if (s->stream != NULL) streamStep(s, dt);
+
+	PROFILE_BEGIN(powerupZone, "powerups");
+	for (int i = 0; i < s->numberPowerups; ) { //a powerup that is caught or falls out of the window takes the place of the last one
+		powerup* pow = &s->powerups[i];
+		bool caught = updatePowerup(pow, &s->paddle, dt);
+		if (caught) {
+			addEvent(s, EVENT_POWERUP_CAUGHT, pow->x, pow->y, pow->type);
+			powerupEffects[pow->type](s);
+		}
+		if (caught || pow->y + pow->radius < s->cameraY - (double)(s->winHeight / 2)) s->powerups[i] = s->powerups[--s->numberPowerups];
+		else i++;
+	}
+	PROFILE_END(powerupZone);
+	if (blockFieldAliveCount(&s->blocks) == 0 && (s->stream == NULL || streamFinished(s->stream))) { //if all the blocks are destroyed the game is won
+		s->status = GAME_WON;
+		return;
+	}
+	/* update positions */
+	movePaddle(s, in, dt);
+
+	/* move the balls and check collisions with the paddle and blocks, the blocks do not change while the balls move */
+	ballJob job = { s, dt };
+	PROFILE_COUNT(PROFILE_BALLS, s->numberBalls);
+	if (s->numberBalls >= BALLS_PARALLEL_MIN) threadPoolFor(s->pool, s->numberBalls, 64, updateBallsTask, &job);
+	else updateBallsTask(&job, 0, s->numberBalls, 0);
+
+	/* merge the hits in ball order, so two balls hitting the same block give the same result on any number of threads */
+	PROFILE_BEGIN(mergeZone, "merge hits");
+	int kept = 0, hits = 0, tests = 0;
+	for (int i = 0; i < s->numberBalls; i++) {
+		ballResult* result = &s->ballResults[i];
+		for (int k = 0; k < result->numberHits; k++) {
+			int index = result->hits[k];
+			if (!BLOCK_ALIVE(&s->blocks, index)) continue; //already destroyed by an earlier hit
+			hits++;
+			s->score += SCORE_HIT;
+			gameBlockChanged(s, index);
+			s->blocks.strength[index]--;
+			if (s->blocks.strength[index] == 0) {
+				addEvent(s, EVENT_BLOCK_BROKEN, s->blocks.x[index], s->blocks.y[index], 0);
+				s->score += SCORE_BROKEN;
+				blockFieldKill(&s->blocks, index);
+				gridRemove(&s->grid, &s->blocks, index);
+				if (s->blockPowerups[index] != 0) dropPowerup(s, index);
+			}
+			else addEvent(s, EVENT_BLOCK_HIT, s->blocks.x[index], s->blocks.y[index], 0);
+		}
+		tests += result->tests;
+		if (result->paddleHit) addEvent(s, EVENT_PADDLE_HIT, s->balls[i].x, s->paddle.y + s->paddle.height / 2.0, 0);
+		if (!result->lost) s->balls[kept++] = s->balls[i];
+	}
+	s->numberBalls = kept;
+	s->collisionTests = tests;
+	PROFILE_COUNT(PROFILE_HITS, hits);
+	PROFILE_END(mergeZone);
+
+	if (s->numberBalls == 0) { //if the last ball hits the bottom it goes back to the center
+		gameSpawnBall(s, 0.0, s->cameraY - 30.0, 60.0, 200.0);
+		s->paddle.x = 0; //the paddle also goes back to the center
+		s->paddle.lives--; //a life is removed
+		addEvent(s, EVENT_LIFE_LOST, s->paddle.x, s->paddle.y, 0);
+	}
+	if (s->paddle.lives == 0) s->status = GAME_LOST; //if the player finishes his lives the game is lost
+}
@@ -0,0 +1,202 @@
+#ifndef GAME_H
+#define GAME_H
+
+// the simulation core of the game: no SDL and no OpenGL in here, so it can also run without a window
+
+#include <stdbool.h>
+#include "arena.h"
+#include "blocks.h"
+#include "grid.h"
+#include "thread.h"
+#include "profile.h"
+#include "fixed.h"
+
+#define POWERUPNUMBER 2
+#define LEVELS_NUMBER 3
+#define PI 3.14159265359 // for the angles of the balls and everything drawn or played around them
+#define GAME_STEP (1.0 / 120.0) // fixed timestep of the simulation, in seconds
+#define BALL_MAX_IMPACTS 16 // bounces the ball can make in a single step
+#define BALLS_MAX 65536 // the multiball powerup stops splitting the balls here
+#define BALLS_RESERVE 256 // balls a level makes room for when it starts, the pool grows past it when a multiball needs more
+#define PADDLE_WIDTH_MAX 80 // the wide powerup stops growing the paddle here
+#define BALLS_PARALLEL_MIN 256 // with fewer balls than this they are not worth spreading over threads
+#define BLOCKS_SCAN_MAX 256 // up to this many blocks a SIMD scan of all of them beats walking the grid
+#define BLOCKS_CHANGED_MAX 64 // block changes remembered for the renderer, after that it redraws all of them
+#define GAME_EVENTS_MAX 256 // effects remembered for the frontend, after that they are dropped
+#define INPUT_SUBSTEPS 256 // the time of an input inside a step is kept in this many parts of the step
+#define INPUT_CHANGES_MAX 8 // direction changes inside a single step, more than that are merged into the last one
+#define PADDLE_POINTER_GAIN 15.0 // with the mouse the paddle closes this part of the gap to the pointer every second (at most at its speed)
+#define SCORE_HIT 10 // points for every hit on a block
+#define SCORE_BROKEN 50 // more points when the block breaks
+
+/* data structures */
+
+typedef struct paddle
+{
+	double x;
+	double y;
+	double width;
+	double height;
+	double speed;
+	int lives; //the 3 lives are assigned to the paddle, which represents the player
+} paddle;
+
+typedef enum powerupType
+{
+	POWERUP_LIFE, //one more life
+	POWERUP_MULTIBALL, //every ball splits in three
+	POWERUP_WIDE, //the paddle gets wider
+	POWERUP_TYPES
+} powerupType;
+
+typedef struct powerup
+{
+	powerupType type;
+	double x;
+	double y;
+	double radius;
+	double speed;
+} powerup;
+
+typedef struct ball
+{
+	double x;
+	double y;
+	double radius;
+	double speedX;
+	double speedY;
+} ball;
+
+typedef struct ballResult //what a ball ran into during a step, applied to the blocks after all the balls have moved
+{
+	int hits[BALL_MAX_IMPACTS]; //blocks, in the order they were hit
+	int numberHits;
+	bool lost; //fell off the bottom
+	bool paddleHit; //bounced on the paddle, only for the effects
+	int tests; //paddle and block sweeps done, for the profiler
+} ballResult;
+
+typedef enum gameStatus
+{
+	GAME_PLAYING,
+	GAME_LOST, //the player has no lives left
+	GAME_WON //every block has been destroyed
+} gameStatus;
+
+typedef enum impact //what the ball has run into
+{
+	IMPACT_NONE,
+	IMPACT_WALL,
+	IMPACT_BOTTOM, //a life is lost
+	IMPACT_PADDLE,
+	IMPACT_BLOCK
+} impact;
+
+typedef enum gameEventType //what the frontend shows an effect for, the game does not use them
+{
+	EVENT_BLOCK_BROKEN,
+	EVENT_PADDLE_HIT,
+	EVENT_POWERUP_CAUGHT,
+	EVENT_BLOCK_HIT, //hit but not broken
+	EVENT_LIFE_LOST
+} gameEventType;
+
+typedef struct gameEvent
+{
+	gameEventType type;
+	float x; //where it happened, in the level
+	float y;
+	int detail; //the powerup type for EVENT_POWERUP_CAUGHT, 0 otherwise
+} gameEvent;
+
+typedef struct gameInput
+{
+	int p1dir; // -1 left, 0 still, 1 right, at the start of the step
+	/* the direction changes inside the step, in order (see input.h): from changeAt[k] parts of INPUT_SUBSTEPS on the
+	   paddle moves in changeDir[k]. With none p1dir is used for the whole step, like before */
+	int numberChanges;
+	unsigned char changeAt[INPUT_CHANGES_MAX];
+	signed char changeDir[INPUT_CHANGES_MAX];
+	bool pointer; //the mouse is used: the paddle follows pointerX instead of the direction
+	double pointerX;
+} gameInput;
+
+typedef struct candidateBuffer //blocks along a ball path when there are more than updateBall keeps on the stack
+{
+	int* blocks;
+	int capacity; //it only grows, so after the first long paths of a level nothing is allocated any more
+} candidateBuffer;
+
+typedef struct gameState
+{
+	arena arena; //the blocks, powerups and balls of the level, sized when it starts
+	ball* balls; //the ball pool on the heap, kept from level to level. While playing there is always at least one ball
+	ballResult* ballResults;
+	candidateBuffer candidates[THREADS_MAX]; //one for every pool worker, they update balls at the same time
+	int numberBalls;
+	int capacityBalls;
+	int extraBalls; //balls the caller adds with gameSpawnBall once the level is set up, the pool makes room for them
+	paddle paddle;
+	blockField blocks;
+	unsigned char* blockPowerups; //for every block 0, or the type of the powerup it holds plus one
+	powerup* powerups; //only the falling ones, a powerup joins when its block is destroyed and leaves when it is caught or lost
+	int numberPowerups;
+	int capacityPowerups;
+	blockGrid grid; //finds the blocks close to the ball
+	int changedBlocks[BLOCKS_CHANGED_MAX]; //blocks hit since the renderer last looked, it sets numberChanged back to 0
+	int numberChanged; //more than BLOCKS_CHANGED_MAX when the whole field has to be redrawn
+	gameEvent events[GAME_EVENTS_MAX]; //since the frontend last looked, it sets numberEvents back to 0. Not in the checksum or snapshots
+	int numberEvents;
+	int winWidth;
+	int winHeight;
+	double cameraY; //centre of the window in the level, only a streamed level moves it
+	struct levelStream* stream; //NULL unless the level is streamed (see stream.h)
+	gameStatus status;
+	int score; //only shown, it is not in the checksum so the replays recorded before it still match
+	int collisionTests; //sweeps done in the last step, for the stats
+	int level; //what gameInitLevel was called with, 0 for a custom level
+	unsigned int seed;
+	unsigned long long rng; //the only source of randomness of the game, so a seed always gives the same game
+	threadPool* pool; //the balls are updated in parallel on it, NULL keeps everything on the calling thread
+} gameState;
+
+void initializePaddle(paddle* p, double x, double y, double w, double h, double sp);
+powerup initializePowerup(double x, double y, powerupType type);
+void initializeBall(ball* b, double x, double y, double r, double sx, double sy);
+
+char powerupXpaddle(powerup* pow, paddle* p);
+char ballXpaddle(ball* b, paddle* p);
+char ballXblock(ball* b, blockField* f, int i);
+
+bool updatePowerup(powerup* pow, paddle* p, double f); // true when the paddle catches it
+void updatePaddle(paddle* p, double f, int d, int w);
+void updatePaddleTowards(paddle* p, double f, double x, int w); // slows down as it gets to x, so the mouse jitter is smoothed
+bool sweepBox(double x, double y, double dx, double dy, double minX, double minY, double maxX, double maxY, double* t, int* axis);
+int nearbyBlocks(blockField* f, blockGrid* grid, double minX, double minY, double maxX, double maxY, int* out, int max);
+// when nearbyBlocks found n > 256 blocks: all of them, in the buffer (grown if it has to). NULL if it cannot grow
+int* moreCandidates(blockField* f, blockGrid* grid, double minX, double minY, double maxX, double maxY, int n, candidateBuffer* buffer);
+// the paddle, blocks and grid are only read, so many balls can be updated at the same time
+void updateBall(ball* b, double f, paddle* p1, blockField* bl1, blockGrid* grid, int w, int h, double cameraY, ballResult* result, candidateBuffer* buffer);
+
+void randomSeed(unsigned long long* rng, unsigned int seed);
+unsigned int randomNext(unsigned long long* rng);
+int randomRange(unsigned long long* rng, int n); // from 0 to n-1
+
+// a gameState has to start zeroed (gameState game = { 0 };), gameInit can then be called again and again for new levels
+void gameInit(gameState* s, int numberPowerups, int numberBlocks, int blocksRows, int winWidth, int winHeight, unsigned int seed);
+/* starts setting up a level: empties the arena, sizes it for the level and takes the powerups from it, and makes room
+   for the first balls. The blocks come next, with blockFieldResize or blockFieldMap (mappedBlocks) on the same arena.
+   false when there is not enough memory, the level is then empty and lost */
+bool gameReserve(gameState* s, int numberBlocks, int numberPowerups, bool mappedBlocks);
+bool gameReserveBalls(gameState* s, int count); // grows the ball pool to at least count balls, false if it cannot
+void gameAddPowerup(gameState* s, int block, powerupType type); // puts a powerup in a block, it falls from there
+void gamePlacePowerups(gameState* s, int count); // puts count powerups of random types in random blocks that have none yet
+void gameBlockChanged(gameState* s, int block); // tells the renderer the block has to be drawn again
+void gameStart(gameState* s, int winWidth, int winHeight); // once the blocks, powerups and grid are set: puts the ball and paddle in place
+void gameInitLevel(gameState* s, int level, int winWidth, int winHeight, unsigned int seed); // level goes from 1 to LEVELS_NUMBER
+void gameStep(gameState* s, const gameInput* in, double dt); // advances the simulation by dt seconds
+unsigned int gameChecksum(const gameState* s); // hash of everything that changes while playing, to check replays
+ball* gameSpawnBall(gameState* s, double x, double y, double sx, double sy); // NULL when the pool is at BALLS_MAX or cannot grow
+void gameFree(gameState* s);
+
+#endif
@@ -0,0 +1,236 @@
+// uniform grid broadphase: every block is put in the cells it covers when the level is built,
+// a query only walks the cells under the box it is asked about
+
+#include "grid.h"
+#include "blocks.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static int cellColumn(blockGrid* g, double x) {
+	int c = (int)floor((x - g->originX) / g->cellSize);
+	if (c < 0) return 0;
+	if (c >= g->columns) return g->columns - 1;
+	return c;
+}
+
+static int cellRow(blockGrid* g, double y) {
+	int r = (int)floor((y - g->originY) / g->cellSize);
+	if (r < 0) return 0;
+	if (r >= g->rows) return g->rows - 1;
+	return r;
+}
+
+void gridBuild(blockGrid* g, blockField* f, double cellSize) {
+	double minX = 0.0, minY = 0.0, maxX = 1.0, maxY = 1.0;
+	double sizeSum = 0.0;
+	for (int i = 0; i < f->count; i++) { //size of the area covered by the blocks
+		if (i == 0 || f->x[i] - f->halfWidth[i] < minX) minX = f->x[i] - f->halfWidth[i];
+		if (i == 0 || f->y[i] - f->halfHeight[i] < minY) minY = f->y[i] - f->halfHeight[i];
+		if (i == 0 || f->x[i] + f->halfWidth[i] > maxX) maxX = f->x[i] + f->halfWidth[i];
+		if (i == 0 || f->y[i] + f->halfHeight[i] > maxY) maxY = f->y[i] + f->halfHeight[i];
+		sizeSum += 2.0 * (f->halfWidth[i] > f->halfHeight[i] ? f->halfWidth[i] : f->halfHeight[i]);
+	}
+	if (cellSize <= 0.0) cellSize = f->count > 0 ? sizeSum / f->count : 32.0; //about one block per cell
+	for (;;) { //sparse levels get bigger cells, so the grid never has many more cells than blocks
+		g->columns = (int)ceil((maxX - minX) / cellSize);
+		g->rows = (int)ceil((maxY - minY) / cellSize);
+		if (g->columns < 1) g->columns = 1;
+		if (g->rows < 1) g->rows = 1;
+		if ((double)g->columns * g->rows <= 4.0 * f->count + 64.0) break;
+		cellSize *= 2.0;
+	}
+	gridBuildArea(g, f, minX, minY, cellSize, g->columns, g->rows);
+}
+
+void gridBuildArea(blockGrid* g, blockField* f, double originX, double originY, double cellSize, int columns, int rows) {
+	g->originX = originX;
+	g->originY = originY;
+	g->cellSize = cellSize;
+	g->columns = columns;
+	g->rows = rows;
+
+	int numberCells = g->columns * g->rows;
+	int entries = 0;
+	if (g->mapped) { //the old cellStart belongs to the level file
+		g->cellStart = NULL;
+		g->capacityCells = 0;
+		g->mapped = false;
+	}
+	for (int i = 0; i < f->count; i++) { //a block can cover more than one cell
+		entries += (cellColumn(g, f->x[i] + f->halfWidth[i]) - cellColumn(g, f->x[i] - f->halfWidth[i]) + 1) *
+			(cellRow(g, f->y[i] + f->halfHeight[i]) - cellRow(g, f->y[i] - f->halfHeight[i]) + 1);
+	}
+	if (numberCells + 1 > g->capacityCells) {
+		g->cellStart = realloc(g->cellStart, (numberCells + 1) * sizeof(int));
+		g->cellCount = realloc(g->cellCount, (numberCells + 1) * sizeof(int));
+		g->capacityCells = numberCells + 1;
+	}
+	if (entries > g->capacityBlocks) {
+		g->cellBlocks = realloc(g->cellBlocks, (entries > 0 ? entries : 1) * sizeof(int));
+		g->capacityBlocks = entries;
+	}
+	g->numberEntries = entries;
+
+	/* counting sort of the blocks into their cells */
+	for (int c = 0; c <= numberCells; c++) g->cellCount[c] = 0;
+	for (int i = 0; i < f->count; i++) {
+		for (int r = cellRow(g, f->y[i] - f->halfHeight[i]); r <= cellRow(g, f->y[i] + f->halfHeight[i]); r++)
+			for (int c = cellColumn(g, f->x[i] - f->halfWidth[i]); c <= cellColumn(g, f->x[i] + f->halfWidth[i]); c++)
+				g->cellCount[r * g->columns + c]++;
+	}
+	g->cellStart[0] = 0;
+	for (int c = 0; c < numberCells; c++) {
+		g->cellStart[c + 1] = g->cellStart[c] + g->cellCount[c];
+		g->cellCount[c] = 0;
+	}
+	for (int i = 0; i < f->count; i++) {
+		if (!BLOCK_ALIVE(f, i)) continue; //destroyed blocks keep their slot but are never reported
+		for (int r = cellRow(g, f->y[i] - f->halfHeight[i]); r <= cellRow(g, f->y[i] + f->halfHeight[i]); r++)
+			for (int c = cellColumn(g, f->x[i] - f->halfWidth[i]); c <= cellColumn(g, f->x[i] + f->halfWidth[i]); c++) {
+				int cell = r * g->columns + c;
+				g->cellBlocks[g->cellStart[cell] + g->cellCount[cell]++] = i;
+			}
+	}
+}
+
+void gridMap(blockGrid* g, double originX, double originY, double cellSize, int columns, int rows, const int* cellStart, const int* cellCount, const int* cellBlocks, int numberEntries) {
+	int numberCells = columns * rows;
+	if (!g->mapped) {
+		free(g->cellStart);
+		g->capacityCells = 0;
+	}
+	if (numberCells + 1 > g->capacityCells) {
+		g->cellCount = realloc(g->cellCount, (numberCells + 1) * sizeof(int));
+		g->capacityCells = numberCells + 1;
+	}
+	if (numberEntries > g->capacityBlocks) {
+		g->cellBlocks = realloc(g->cellBlocks, (numberEntries > 0 ? numberEntries : 1) * sizeof(int));
+		g->capacityBlocks = numberEntries;
+	}
+	g->originX = originX;
+	g->originY = originY;
+	g->cellSize = cellSize;
+	g->columns = columns;
+	g->rows = rows;
+	g->cellStart = (int*)cellStart;
+	g->mapped = true;
+	g->numberEntries = numberEntries;
+	memcpy(g->cellCount, cellCount, (numberCells + 1) * sizeof(int));
+	memcpy(g->cellBlocks, cellBlocks, numberEntries * sizeof(int));
+}
+
+void gridRemove(blockGrid* g, blockField* f, int index) {
+	int i = index;
+	for (int r = cellRow(g, f->y[i] - f->halfHeight[i]); r <= cellRow(g, f->y[i] + f->halfHeight[i]); r++)
+		for (int c = cellColumn(g, f->x[i] - f->halfWidth[i]); c <= cellColumn(g, f->x[i] + f->halfWidth[i]); c++) {
+			int cell = r * g->columns + c;
+			int* items = g->cellBlocks + g->cellStart[cell];
+			for (int k = 0; k < g->cellCount[cell]; k++) {
+				if (items[k] == index) { //the blocks after it move down one, so the alive ones stay sorted by index
+					memmove(items + k, items + k + 1, (--g->cellCount[cell] - k) * sizeof(int));
+					items[g->cellCount[cell]] = index;
+					break;
+				}
+			}
+		}
+}
+
+void gridRevive(blockGrid* g, blockField* f, int index) {
+	int i = index;
+	for (int r = cellRow(g, f->y[i] - f->halfHeight[i]); r <= cellRow(g, f->y[i] + f->halfHeight[i]); r++)
+		for (int c = cellColumn(g, f->x[i] - f->halfWidth[i]); c <= cellColumn(g, f->x[i] + f->halfWidth[i]); c++) {
+			int cell = r * g->columns + c;
+			int* items = g->cellBlocks + g->cellStart[cell];
+			int end = g->cellStart[cell + 1] - g->cellStart[cell];
+			for (int k = g->cellCount[cell]; k < end; k++) {
+				if (items[k] != index) continue;
+				int at = g->cellCount[cell]++; //back among the alive blocks, in its place by index
+				items[k] = items[at];
+				while (at > 0 && items[at - 1] > index) {
+					items[at] = items[at - 1];
+					at--;
+				}
+				items[at] = index;
+				break;
+			}
+		}
+}
+
+int gridQuery(blockGrid* g, blockField* f, double minX, double minY, double maxX, double maxY, int* out, int max) {
+	int found = 0;
+	if (g->cellStart == NULL || g->rows == 0) return 0;
+	int c0 = cellColumn(g, minX), c1 = cellColumn(g, maxX);
+	int r0 = cellRow(g, minY), r1 = cellRow(g, maxY);
+	for (int r = r0; r <= r1; r++) {
+		for (int c = c0; c <= c1; c++) {
+			int cell = r * g->columns + c;
+			int* items = g->cellBlocks + g->cellStart[cell];
+			for (int k = 0; k < g->cellCount[cell]; k++) {
+				int i = items[k];
+				if (f->x[i] + f->halfWidth[i] < minX || f->x[i] - f->halfWidth[i] > maxX ||
+					f->y[i] + f->halfHeight[i] < minY || f->y[i] - f->halfHeight[i] > maxY) continue;
+				/* a block covering more cells is only reported by the first cell it shares with the box */
+				int bc = cellColumn(g, f->x[i] - f->halfWidth[i]), br = cellRow(g, f->y[i] - f->halfHeight[i]);
+				if (c != (bc > c0 ? bc : c0) || r != (br > r0 ? br : r0)) continue;
+				if (found < max) out[found] = items[k];
+				found++;
+			}
+		}
+	}
+	return found;
+}
+
+static void reserveGrid(blockGrid* g, int cells, int entries) { //room for cells+1 cells and entries blocks, keeping what is there
+	if (cells + 1 > g->capacityCells) {
+		g->cellStart = realloc(g->cellStart, (cells + 1) * sizeof(int));
+		g->cellCount = realloc(g->cellCount, (cells + 1) * sizeof(int));
+		g->capacityCells = cells + 1;
+	}
+	if (entries > g->capacityBlocks) {
+		g->cellBlocks = realloc(g->cellBlocks, (entries > 0 ? entries : 1) * sizeof(int));
+		g->capacityBlocks = entries;
+	}
+}
+
+void gridAppendRows(blockGrid* g, const blockGrid* top, int indexOffset) {
+	if (g->rows == 0) { //the first chunk gives the layout
+		g->originX = top->originX;
+		g->originY = top->originY;
+		g->cellSize = top->cellSize;
+		g->columns = top->columns;
+		g->numberEntries = 0;
+	}
+	int cells = g->columns * g->rows, topCells = top->columns * top->rows;
+	reserveGrid(g, cells + topCells, g->numberEntries + top->numberEntries);
+	g->cellStart[cells] = g->numberEntries;
+	for (int c = 0; c < topCells; c++) {
+		g->cellStart[cells + c + 1] = g->numberEntries + top->cellStart[c + 1];
+		g->cellCount[cells + c] = top->cellCount[c];
+	}
+	for (int k = 0; k < top->numberEntries; k++) g->cellBlocks[g->numberEntries + k] = top->cellBlocks[k] + indexOffset;
+	g->numberEntries += top->numberEntries;
+	g->rows += top->rows;
+}
+
+void gridDropRows(blockGrid* g, int rows) {
+	if (rows > g->rows) rows = g->rows;
+	int dropped = rows * g->columns, cells = g->columns * g->rows - dropped;
+	int entries = g->cellStart[dropped];
+	memmove(g->cellBlocks, g->cellBlocks + entries, (g->numberEntries - entries) * sizeof(int));
+	memmove(g->cellCount, g->cellCount + dropped, cells * sizeof(int));
+	for (int c = 0; c <= cells; c++) g->cellStart[c] = g->cellStart[c + dropped] - entries;
+	g->numberEntries -= entries;
+	g->rows -= rows;
+	g->originY += rows * g->cellSize;
+}
+
+void gridFree(blockGrid* g) {
+	if (!g->mapped) free(g->cellStart);
+	free(g->cellCount);
+	free(g->cellBlocks);
+	g->cellStart = g->cellCount = g->cellBlocks = NULL;
+	g->capacityCells = g->capacityBlocks = 0;
+	g->columns = g->rows = g->numberEntries = 0;
+	g->mapped = false;
+}
@@ -0,0 +1,42 @@
+#ifndef GRID_H
+#define GRID_H
+
+// uniform grid over the blocks of a level, so the ball only looks at the blocks close to it
+
+#include <stdbool.h>
+
+struct blockField;
+
+typedef struct blockGrid
+{
+	double originX; //bottom left corner of the grid
+	double originY;
+	double cellSize;
+	int columns;
+	int rows;
+	int* cellStart; //where the blocks of every cell start in cellBlocks (columns*rows+1 entries)
+	int* cellCount; //how many blocks of every cell are still alive, they are kept at the front of the cell
+	int* cellBlocks; //block indices, grouped by cell
+	int capacityCells; //allocated sizes, so that a new level can reuse the memory
+	int capacityBlocks;
+	int numberEntries; //used part of cellBlocks
+	bool mapped; //cellStart points into a level file (see level.h), cellCount and cellBlocks are still ours
+} blockGrid;
+
+void gridBuild(blockGrid* g, struct blockField* f, double cellSize); // cellSize 0 picks one from the block size
+// the same with a layout chosen by the caller, blocks outside of it go in the cells at its border
+void gridBuildArea(blockGrid* g, struct blockField* f, double originX, double originY, double cellSize, int columns, int rows);
+// a grid built before (gridBuild on the same blocks, all alive) and saved: cellStart is used in place, the rest is copied
+void gridMap(blockGrid* g, double originX, double originY, double cellSize, int columns, int rows, const int* cellStart, const int* cellCount, const int* cellBlocks, int numberEntries);
+void gridRemove(blockGrid* g, struct blockField* f, int index); // call it when a block gets destroyed
+/* undoes gridRemove (see snapshot.h). The alive blocks of a cell are always kept sorted by index, so the grid
+   only depends on which blocks are alive and not on the order they were destroyed in */
+void gridRevive(blockGrid* g, struct blockField* f, int index);
+int gridQuery(blockGrid* g, struct blockField* f, double minX, double minY, double maxX, double maxY, int* out, int max); // alive blocks overlapping the box, each reported once
+/* a streamed level (see stream.h) keeps one grid over the chunks it has loaded: the grid of a new chunk goes on top
+   (same columns and cell size, block indices moved by indexOffset) and the rows of the chunks it passed are dropped */
+void gridAppendRows(blockGrid* g, const blockGrid* top, int indexOffset);
+void gridDropRows(blockGrid* g, int rows);
+void gridFree(blockGrid* g);
+
+#endif
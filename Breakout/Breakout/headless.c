@@ -0,0 +1,192 @@
+// runs the game without a window: no SDL, no OpenGL, just the simulation as fast as the CPU allows
+// compile with: make headless, the sources it needs are listed in the Makefile
+// usage: headless [-l level] [-n steps] [-s seed] [-d step in ms] [-b balls] [-t threads] [-r record file] [-p playback file] [-m level pack] [-P trace file] [-g chunks] [-c columns]
+// with -m the level is a number from 1 or a name from the pack, with -g it is a streamed level of that many chunks (0 never ends)
+
+#include "game.h"
+#include "replay.h"
+#include "level.h"
+#include "stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WIN_WIDTH 640
+#define WIN_HEIGHT 480
+
+int scriptedPlayer(gameState* s) { //the paddle follows the lowest ball that is coming down
+	ball* target = &s->balls[0];
+	for (int i = 1; i < s->numberBalls; i++) {
+		ball* b = &s->balls[i];
+		if ((b->speedY < 0.0 && target->speedY >= 0.0) || ((b->speedY < 0.0) == (target->speedY < 0.0) && b->y < target->y)) target = b;
+	}
+	if (target->x > s->paddle.x + s->paddle.width / 4.0) return 1;
+	if (target->x < s->paddle.x - s->paddle.width / 4.0) return -1;
+	return 0;
+}
+
+void spawnExtraBalls(gameState* s, int balls) { //stress test: the extra balls start under the blocks going up
+	for (int i = 1; i < balls; i++) {
+		double x = randomRange(&s->rng, WIN_WIDTH - 40) - (WIN_WIDTH / 2 - 20);
+		double y = randomRange(&s->rng, 200) - 150;
+		gameSpawnBall(s, x, y, randomRange(&s->rng, 400) - 200, 150 + randomRange(&s->rng, 150));
+	}
+}
+
+void startGame(gameState* s, const levelPack* pack, streamSettings* stream, int level, unsigned int seed, int balls) {
+	s->extraBalls = balls - 1;
+	if (stream != NULL) {
+		stream->seed = seed;
+		gameInitStream(s, stream, WIN_WIDTH, WIN_HEIGHT);
+	}
+	else if (pack != NULL) gameInitPacked(s, pack, level, WIN_WIDTH, WIN_HEIGHT, seed);
+	else gameInitLevel(s, level, WIN_WIDTH, WIN_HEIGHT, seed);
+	spawnExtraBalls(s, balls);
+}
+
+double wallClock(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int playback(const char* path, int threads) { //plays a replay as fast as possible and checks it gives the same game
+	replayReader reader;
+	if (!replayOpenRead(&reader, path)) {
+		printf("cannot read the replay %s\n", path);
+		return 1;
+	}
+	if (reader.header.fixedPoint != GAME_FIXED_POINT) {
+		printf("the replay %s was recorded by the %s build, play it with %s\n", path, reader.header.fixedPoint ? "fixed point" : "normal",
+			reader.header.fixedPoint ? "headless_fixed" : "headless");
+		replayCloseRead(&reader);
+		return 1;
+	}
+	gameState game = { 0 };
+	game.pool = threadPoolCreate(threads);
+	replayStart(&reader, &game);
+	replayResult result;
+	double start = wallClock();
+	while ((result = replayStep(&reader, &game)) == REPLAY_OK);
+	double seconds = wallClock() - start;
+
+	printf("replay %s: level %d, seed %u, %lld steps (%.1f s of game time) in %.3f s, %.0fx real time\n", path, reader.header.level, reader.header.seed,
+		reader.steps, reader.steps * reader.header.step, seconds, reader.steps * reader.header.step / seconds);
+	if (result == REPLAY_FINISHED) printf("the game is the same as the recording: %s\n", game.status == GAME_WON ? "won" : game.status == GAME_LOST ? "lost" : "still playing");
+	else if (result == REPLAY_MISMATCH) printf("the game went different from the recording at step %lld\n", reader.mismatchStep);
+	else printf("the replay is cut or broken after step %lld\n", reader.steps);
+	replayCloseRead(&reader);
+	threadPoolDestroy(game.pool);
+	gameFree(&game);
+	return result == REPLAY_FINISHED ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* levelName = "1";
+	const char* packPath = NULL;
+	const char* tracePath = NULL;
+	long long steps = 10000000;
+	unsigned int seed = 1;
+	double dt = GAME_STEP; //bigger steps are fine, the ball never skips through anything
+	int balls = 1;
+	int threads = 1;
+	const char* recordPath = NULL;
+	const char* playbackPath = NULL;
+	int chunks = -1;
+	int columns = 0;
+
+	for (int i = 1; i < argc; i += 2) {
+		if (i + 1 >= argc) i = argc; //a flag without its value shows the usage
+		else if (strcmp(argv[i], "-l") == 0) { levelName = argv[i + 1]; continue; }
+		else if (strcmp(argv[i], "-n") == 0) { steps = atoll(argv[i + 1]); continue; }
+		else if (strcmp(argv[i], "-s") == 0) { seed = (unsigned int)strtoul(argv[i + 1], NULL, 10); continue; }
+		else if (strcmp(argv[i], "-d") == 0) { dt = atof(argv[i + 1]) / 1000.0; continue; }
+		else if (strcmp(argv[i], "-b") == 0) { balls = atoi(argv[i + 1]); continue; }
+		else if (strcmp(argv[i], "-t") == 0) { threads = atoi(argv[i + 1]); continue; }
+		else if (strcmp(argv[i], "-r") == 0) { recordPath = argv[i + 1]; continue; }
+		else if (strcmp(argv[i], "-p") == 0) { playbackPath = argv[i + 1]; continue; }
+		else if (strcmp(argv[i], "-m") == 0) { packPath = argv[i + 1]; continue; }
+		else if (strcmp(argv[i], "-P") == 0) { tracePath = argv[i + 1]; continue; }
+		else if (strcmp(argv[i], "-g") == 0) { chunks = atoi(argv[i + 1]); continue; }
+		else if (strcmp(argv[i], "-c") == 0) { columns = atoi(argv[i + 1]); continue; }
+		printf("usage: headless [-l level] [-n steps] [-s seed] [-d step in ms] [-b balls] [-t threads, 0 = one per CPU] [-r record the first game] [-p play a replay] [-m level pack] [-P profile every step to a trace file] [-g streamed level of that many chunks, 0 = endless] [-c blocks per row of the streamed level]\n");
+		return 1;
+	}
+	if (playbackPath != NULL) return playback(playbackPath, threads);
+	if (recordPath != NULL && (balls > 1 || packPath != NULL || chunks >= 0)) { //the extra balls, the packs and the streamed levels are not part of a replay
+		printf("-r only works with one ball and the built in levels\n");
+		return 1;
+	}
+	levelPack packStorage;
+	levelPack* pack = NULL;
+	int level = atoi(levelName);
+	if (packPath != NULL) {
+		if (!levelPackOpen(&packStorage, packPath)) {
+			printf("%s is not a level pack\n", packPath);
+			return 1;
+		}
+		pack = &packStorage;
+		level = levelPackFind(pack, levelName);
+		if (level < 0) level = atoi(levelName) - 1;
+		if (level < 0 || level >= levelPackCount(pack)) {
+			printf("%s has no level %s\n", packPath, levelName);
+			return 1;
+		}
+	}
+
+	streamSettings streamStorage;
+	streamSettings* stream = NULL;
+	if (chunks >= 0) {
+		streamDefaults(&streamStorage);
+		streamStorage.chunks = chunks;
+		if (columns > 0) streamStorage.columns = columns;
+		stream = &streamStorage;
+	}
+
+	gameState game = { 0 };
+	gameInput input = { 0 };
+	int won = 0, lost = 0;
+	long long ballSteps = 0;
+
+	game.pool = threadPoolCreate(threads);
+	startGame(&game, pack, stream, level, seed, balls);
+	replayWriter writer = { 0 };
+	if (recordPath != NULL && !replayOpenWrite(&writer, recordPath, &game, dt)) {
+		printf("cannot write the replay %s\n", recordPath);
+		return 1;
+	}
+	if (tracePath != NULL) profileSetEnabled(true);
+	double start = wallClock();
+	for (long long i = 0; i < steps; i++) {
+		profileFrameBegin(); //a frame is one step here
+		input.p1dir = scriptedPlayer(&game);
+		ballSteps += game.numberBalls;
+		gameStep(&game, &input, dt);
+		profileFrameEnd();
+		replayRecord(&writer, &input, &game);
+		if (game.status != GAME_PLAYING) { //a new game starts straight away, like going back to the menu
+			replayCloseWrite(&writer, &game); //only the first game is recorded
+			if (game.status == GAME_WON) won++;
+			else lost++;
+			startGame(&game, pack, stream, level, ++seed, balls);
+		}
+	}
+	double seconds = wallClock() - start;
+	replayCloseWrite(&writer, &game);
+
+	if (stream != NULL) printf("streamed level, %d chunks loaded, %d blocks in memory: ", game.stream->numberLoaded, game.blocks.capacity);
+	printf("level %s: %lld steps (%.1f s of game time) in %.3f s on %d threads\n", pack != NULL ? levelPackName(pack, level) : levelName, steps, steps * dt, seconds, game.pool->numberWorkers);
+	printf("%.0f steps/s, %.0fx real time, %.0f ball updates/s\n", steps / seconds, steps * dt / seconds, ballSteps / seconds);
+	printf("games won: %d, games lost: %d, lives left: %d, balls: %d\n", won, lost, game.paddle.lives, game.numberBalls);
+	if (tracePath != NULL) {
+		if (profileWriteTrace(tracePath)) printf("profile saved to %s\n", tracePath);
+		profileSummary(stdout);
+	}
+	threadPoolDestroy(game.pool);
+	gameFree(&game);
+	profileFree();
+	if (pack != NULL) levelPackClose(pack);
+	return 0;
+}
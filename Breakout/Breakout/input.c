@@ -0,0 +1,77 @@
+// the timestamped input queue, see input.h
+
+#include "input.h"
+#include <string.h>
+
+void inputInit(inputQueue* q) {
+	memset(q, 0, sizeof(*q));
+}
+
+static bool push(inputQueue* q, const inputEvent* e) {
+	if (q->head - q->tail >= INPUT_QUEUE_SIZE) {
+		q->dropped++;
+		return false;
+	}
+	q->events[q->head & (INPUT_QUEUE_SIZE - 1)] = *e;
+	q->head++;
+	return true;
+}
+
+bool inputPushDirection(inputQueue* q, double time, int dir) {
+	inputEvent e = { time, INPUT_DIRECTION, dir, 0.0 };
+	return push(q, &e);
+}
+
+bool inputPushPointer(inputQueue* q, double time, double x) {
+	inputEvent e = { time, INPUT_POINTER, 0, x };
+	return push(q, &e);
+}
+
+void inputTake(inputQueue* q, double stepStart, double step, double now, gameInput* in) {
+	in->p1dir = q->dir;
+	in->numberChanges = 0;
+	for (; q->tail != q->head; q->tail++) {
+		const inputEvent* e = &q->events[q->tail & (INPUT_QUEUE_SIZE - 1)];
+		if (e->time >= stepStart + step) break; //it belongs to a later step
+		double latency = now - e->time;
+		q->latencySum += latency;
+		if (latency > q->latencyWorst) q->latencyWorst = latency;
+		q->latencySamples++;
+		q->totalLatency += latency;
+		q->totalLatencySamples++;
+
+		if (e->kind == INPUT_POINTER) {
+			q->pointer = true;
+			q->pointerX = e->x;
+			continue;
+		}
+		q->pointer = false;
+		if (e->dir == q->dir) continue; //a key repeating
+		int at = e->time <= stepStart ? 0 : (int)((e->time - stepStart) / step * INPUT_SUBSTEPS);
+		if (at > INPUT_SUBSTEPS - 1) at = INPUT_SUBSTEPS - 1;
+		if (in->numberChanges > 0 && at < in->changeAt[in->numberChanges - 1]) at = in->changeAt[in->numberChanges - 1];
+		if (in->numberChanges == INPUT_CHANGES_MAX) in->changeDir[INPUT_CHANGES_MAX - 1] = (signed char)e->dir; //too many, the last one wins
+		else {
+			in->changeAt[in->numberChanges] = (unsigned char)at;
+			in->changeDir[in->numberChanges] = (signed char)e->dir;
+			in->numberChanges++;
+		}
+		q->dir = e->dir;
+	}
+	in->pointer = q->pointer;
+	in->pointerX = q->pointerX;
+}
+
+bool inputReport(inputQueue* q, char* text, int size) {
+	if (q->latencySamples == 0) return false;
+	snprintf(text, size, "input used %.1f ms after it happened (worst %.1f ms)", 1000.0 * q->latencySum / q->latencySamples, 1000.0 * q->latencyWorst);
+	q->latencySum = q->latencyWorst = 0.0;
+	q->latencySamples = 0;
+	return true;
+}
+
+void inputSummary(const inputQueue* q, FILE* out) {
+	if (q->totalLatencySamples == 0) return;
+	fprintf(out, "%d input events used by the simulation on average %.2f ms after they happened, %d dropped because the queue was full\n",
+		q->totalLatencySamples, 1000.0 * q->totalLatency / q->totalLatencySamples, q->dropped);
+}
@@ -0,0 +1,55 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+// the input of the player between two frames: every event is kept in a ring buffer with the time it happened, and every
+// gameStep takes the ones that fall in the time the step covers. A key pressed half way through a step moves the paddle
+// from half way, and a quick tap moves it for as long as it was held, whatever the frame rate
+// Times are in seconds on any clock, as long as the events and the steps use the same one (main uses pacerNow)
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "game.h"
+
+#define INPUT_QUEUE_SIZE 256 // events waiting for their step, a power of two
+
+typedef enum inputKind
+{
+	INPUT_DIRECTION, //a key: the paddle goes left, right or stops
+	INPUT_POINTER //the mouse moved
+} inputKind;
+
+typedef struct inputEvent
+{
+	double time;
+	inputKind kind;
+	int dir;
+	double x; //where the pointer is, in game coordinates
+} inputEvent;
+
+typedef struct inputQueue
+{
+	inputEvent events[INPUT_QUEUE_SIZE];
+	unsigned int head; //next event pushed, the counters only go up and wrap around
+	unsigned int tail; //next event taken
+	int dir; //the direction after all the events taken so far
+	bool pointer; //the last event taken was the mouse, it steers the paddle until a key is pressed
+	double pointerX;
+	int dropped; //events pushed while the queue was full
+	/* how long the events waited between happening and the step that used them being simulated */
+	double latencySum;
+	double latencyWorst;
+	int latencySamples;
+	double totalLatency;
+	int totalLatencySamples;
+} inputQueue;
+
+void inputInit(inputQueue* q);
+bool inputPushDirection(inputQueue* q, double time, int dir); // false if the queue is full
+bool inputPushPointer(inputQueue* q, double time, double x);
+/* the input of the step that covers stepStart to stepStart + step, now is when it is simulated (for the latency).
+   The events before the step count from its start, the ones after it wait for the next steps */
+void inputTake(inputQueue* q, double stepStart, double step, double now, gameInput* in);
+bool inputReport(inputQueue* q, char* text, int size); // the latency since the last report, false if there was no input
+void inputSummary(const inputQueue* q, FILE* out);
+
+#endif
@@ -0,0 +1,128 @@
+// memory mapped level packs, see level.h for the layout of the file
+
+#include "level.h"
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static bool mapFile(levelPack* p, const char* path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER size;
+	HANDLE mapping = NULL;
+	const void* data = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0) mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping != NULL) data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL) {
+		if (mapping != NULL) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	p->file = file;
+	p->mapping = mapping;
+	p->data = data;
+	p->size = (size_t)size.QuadPart;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	void* data = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); //the mapping keeps the file alive
+	if (data == MAP_FAILED) return false;
+	p->data = data;
+	p->size = (size_t)st.st_size;
+#endif
+	return true;
+}
+
+static void unmapFile(levelPack* p) {
+#ifdef _WIN32
+	UnmapViewOfFile(p->data);
+	CloseHandle(p->mapping);
+	CloseHandle(p->file);
+#else
+	munmap((void*)p->data, p->size);
+#endif
+}
+
+unsigned long long levelDataSize(const levelIndexEntry* e) {
+	unsigned long long cells = (unsigned long long)e->columns * e->rows + 1;
+	return 5ull * e->capacity * sizeof(float) + (2 * cells + e->numberEntries) * sizeof(int) + e->numberPowerups * (sizeof(unsigned int) + 1ull);
+}
+
+bool levelPackOpen(levelPack* p, const char* path) {
+	memset(p, 0, sizeof(*p));
+	if (!mapFile(p, path)) return false;
+
+	/* only the header and the index are checked, the blocks are not touched until a level is played */
+	const levelFileHeader* h = (const levelFileHeader*)p->data;
+	bool ok = p->size >= sizeof(levelFileHeader) && memcmp(h->magic, "BKLV", 4) == 0 && h->version == LEVEL_VERSION
+		&& h->endian == LEVEL_ENDIAN_MARKER && h->numberLevels <= (p->size - sizeof(levelFileHeader)) / sizeof(levelIndexEntry);
+	const levelIndexEntry* index = (const levelIndexEntry*)(p->data + sizeof(levelFileHeader));
+	for (unsigned int i = 0; ok && i < h->numberLevels; i++) {
+		const levelIndexEntry* e = &index[i];
+		ok = e->offset % LEVEL_ALIGN == 0 && e->capacity == ((e->numberBlocks + 31) & ~31u) && e->capacity > 0
+			&& e->numberPowerups <= e->numberBlocks && e->columns > 0 && e->rows > 0 && e->columns * (unsigned long long)e->rows < 0x7fffffff
+			&& e->offset <= p->size && levelDataSize(e) <= p->size - e->offset
+			&& memchr(e->name, 0, LEVEL_NAME_SIZE) != NULL;
+	}
+	if (!ok) {
+		levelPackClose(p);
+		return false;
+	}
+	p->header = h;
+	p->index = index;
+	return true;
+}
+
+void levelPackClose(levelPack* p) {
+	if (p->data != NULL) unmapFile(p);
+	memset(p, 0, sizeof(*p));
+}
+
+int levelPackCount(const levelPack* p) {
+	return p->header != NULL ? (int)p->header->numberLevels : 0;
+}
+
+int levelPackFind(const levelPack* p, const char* name) {
+	for (int i = 0; i < levelPackCount(p); i++) {
+		if (strcmp(p->index[i].name, name) == 0) return i;
+	}
+	return -1;
+}
+
+const char* levelPackName(const levelPack* p, int level) {
+	return p->index[level].name;
+}
+
+void gameInitPacked(gameState* s, const levelPack* p, int level, int winWidth, int winHeight, unsigned int seed) {
+	const levelIndexEntry* e = &p->index[level];
+	const float* columns = (const float*)(p->data + e->offset);
+	const int* cellStart = (const int*)(columns + 5 * e->capacity);
+	const int* cellCount = cellStart + e->columns * e->rows + 1;
+	const int* cellBlocks = cellCount + e->columns * e->rows + 1;
+	const unsigned int* powerupBlocks = (const unsigned int*)(cellBlocks + e->numberEntries);
+	const unsigned char* powerupTypes = (const unsigned char*)(powerupBlocks + e->numberPowerups);
+
+	randomSeed(&s->rng, seed);
+	s->seed = seed;
+	s->level = 0;
+	if (!gameReserve(s, (int)e->numberBlocks, (int)e->numberPowerups, true)) return;
+	blockFieldMap(&s->blocks, (int)e->numberBlocks, columns, columns + e->capacity, columns + 2 * e->capacity, columns + 3 * e->capacity, columns + 4 * e->capacity, &s->arena);
+	gridMap(&s->grid, e->originX, e->originY, e->cellSize, (int)e->columns, (int)e->rows, cellStart, cellCount, cellBlocks, (int)e->numberEntries);
+	int drawn = 0; //the powerups of the level that are not pinned to a block, they go in random blocks every time it starts
+	for (unsigned int i = 0; i < e->numberPowerups; i++) {
+		if (powerupBlocks[i] == LEVEL_POWERUP_RANDOM) drawn++;
+		else if (powerupBlocks[i] < e->numberBlocks && powerupTypes[i] < POWERUP_TYPES) gameAddPowerup(s, (int)powerupBlocks[i], (powerupType)powerupTypes[i]);
+	}
+	gamePlacePowerups(s, drawn);
+	gameStart(s, winWidth, winHeight);
+}
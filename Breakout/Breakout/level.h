@@ -0,0 +1,76 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+// level packs: many levels in one binary file that is memory mapped and used in place. Nothing is parsed: the positions
+// and sizes of the blocks and the cells of their grid are read straight from the file, what changes while playing
+// (strengths, alive blocks of every cell) is copied with a memcpy.
+//
+//   levelFileHeader                   "BKLV", version, number of levels
+//   levelIndexEntry[numberLevels]     where every level is, how big it is, its grid and its name
+//   for every level, starting on a 64 byte boundary:
+//     float x[capacity], y[capacity], halfWidth[capacity], halfHeight[capacity], strength[capacity]
+//     int cellStart[columns*rows+1], cellCount[columns*rows+1], cellBlocks[numberEntries]   (a blockGrid as gridBuild makes it)
+//     unsigned int powerupBlocks[numberPowerups]      LEVEL_POWERUP_RANDOM for a powerup drawn when the level starts
+//     unsigned char powerupTypes[numberPowerups]      (its type is drawn too)
+//
+// capacity is numberBlocks rounded up to 32 and the padding is zero, like in a blockField. The numbers are in the byte
+// order of the machine that wrote the file, the header has a marker to check it. Opening a pack only checks that the
+// sizes in the index fit in the file, the contents are trusted. levelpack.c makes these files from text.
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "game.h"
+
+#define LEVEL_VERSION 1
+#define LEVEL_ENDIAN_MARKER 0x01020304u
+#define LEVEL_NAME_SIZE 24
+#define LEVEL_ALIGN 64
+#define LEVEL_POWERUP_RANDOM 0xffffffffu // not pinned to a block, gameInitPacked puts it in a random one like gameInitLevel does
+
+typedef struct levelFileHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int endian; //LEVEL_ENDIAN_MARKER as written by the machine that made the file
+	unsigned int numberLevels;
+} levelFileHeader;
+
+typedef struct levelIndexEntry
+{
+	unsigned long long offset; //from the start of the file
+	unsigned int numberBlocks;
+	unsigned int capacity;
+	unsigned int numberPowerups;
+	unsigned int columns; //of the grid
+	unsigned int rows;
+	unsigned int numberEntries;
+	double originX;
+	double originY;
+	double cellSize;
+	char name[LEVEL_NAME_SIZE]; //ends with a 0
+} levelIndexEntry;
+
+typedef struct levelPack
+{
+	const unsigned char* data; //the whole file
+	size_t size;
+	const levelFileHeader* header;
+	const levelIndexEntry* index;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+} levelPack;
+
+unsigned long long levelDataSize(const levelIndexEntry* e); // bytes of the level after its offset
+
+bool levelPackOpen(levelPack* p, const char* path); // maps the file and checks the index, false if it is not a level pack
+void levelPackClose(levelPack* p); // the games using its levels have to be done with them (or have gameInit called again)
+int levelPackCount(const levelPack* p);
+int levelPackFind(const levelPack* p, const char* name); // index of the level with that name, -1 if there is none
+const char* levelPackName(const levelPack* p, int level);
+
+// like gameInitLevel, but with level number (from 0) of the pack. The pack has to stay open while the level is played
+void gameInitPacked(gameState* s, const levelPack* p, int level, int winWidth, int winHeight, unsigned int seed);
+
+#endif
@@ -0,0 +1,245 @@
+// makes a level pack (see level.h) from a text file, or lists the levels of one
+// compile with: make levelpack, the sources it needs are listed in the Makefile
+// usage: levelpack levels.txt levels.bkl   or   levelpack -l levels.bkl
+//
+// the text file has one command per line, commas work as spaces so the blocks can also be written as CSV:
+//   # a comment
+//   level <name>                                      starts a new level
+//   grid <columns> <block width> <block height> <spacing> <top>
+//                                                     layout of the rows that follow, centred on the window (the default is the original 8 columns)
+//   row <cell> <cell> ...                             one row of the grid: 1 to 5 is the strength of the block, . is a gap,
+//                                                     an L, M or W after the strength puts a life, multiball or wide paddle powerup in the block
+//   block <x> <y> <width> <height> <strength> [L|M|W] one block anywhere, (0,0) is the centre of the window
+//   powerups <count>                                  that many more powerups of random types, put in random blocks every time the level starts
+
+#include "level.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+typedef struct levelSource
+{
+	char name[LEVEL_NAME_SIZE];
+	float* x; //x, y, halfWidth, halfHeight and strength of every block, one after the other
+	int numberBlocks;
+	int capacityBlocks;
+	unsigned int* powerupBlocks;
+	unsigned char* powerupTypes;
+	int numberPowerups; //the ones pinned to a block
+	int randomPowerups; //drawn by gameInitPacked
+	int row; //rows of the grid so far
+	int columns; //the grid
+	double blockWidth;
+	double blockHeight;
+	double spacing;
+	double top;
+} levelSource;
+
+static int fail(const char* path, int line, const char* message) {
+	printf("%s:%d: %s\n", path, line, message);
+	return 1;
+}
+
+static char* arguments(void) { //the rest of the line
+	char* rest = strtok(NULL, "");
+	return rest != NULL ? rest : "";
+}
+
+static const char powerupLetters[POWERUP_TYPES + 1] = "LMW"; //in the order of powerupType
+
+static bool addBlock(levelSource* l, double x, double y, double w, double h, int strength, char powerup) {
+	if (strength < 1 || strength > 5) return false; //there is a colour for 5 strengths
+	if (powerup != 0 && strchr(powerupLetters, powerup) == NULL) return false;
+	if (l->numberBlocks == l->capacityBlocks) {
+		l->capacityBlocks = l->capacityBlocks ? l->capacityBlocks * 2 : 64;
+		l->x = realloc(l->x, l->capacityBlocks * 5 * sizeof(float));
+		l->powerupBlocks = realloc(l->powerupBlocks, l->capacityBlocks * sizeof(unsigned int));
+		l->powerupTypes = realloc(l->powerupTypes, l->capacityBlocks);
+	}
+	float* b = l->x + l->numberBlocks * 5;
+	b[0] = (float)x;
+	b[1] = (float)y;
+	b[2] = (float)(w / 2.0);
+	b[3] = (float)(h / 2.0);
+	b[4] = (float)strength;
+	if (powerup != 0) {
+		l->powerupBlocks[l->numberPowerups] = l->numberBlocks;
+		l->powerupTypes[l->numberPowerups++] = (unsigned char)(strchr(powerupLetters, powerup) - powerupLetters);
+	}
+	l->numberBlocks++;
+	return true;
+}
+
+static void setGrid(levelSource* l, int columns, double blockWidth, double blockHeight, double spacing, double top) {
+	l->columns = columns;
+	l->blockWidth = blockWidth;
+	l->blockHeight = blockHeight;
+	l->spacing = spacing;
+	l->top = top;
+	l->row = 0;
+}
+
+static int readSource(const char* path, levelSource** levels, int* numberLevels) {
+	FILE* f = fopen(path, "r");
+	if (f == NULL) return fail(path, 0, "cannot open the file");
+	char text[4096];
+	int line = 0;
+	levelSource* l = NULL;
+	*levels = NULL;
+	*numberLevels = 0;
+	while (fgets(text, sizeof(text), f) != NULL) {
+		line++;
+		for (char* c = text; *c; c++) if (*c == ',') *c = ' ';
+		char* word = strtok(text, " \t\r\n");
+		if (word == NULL || word[0] == '#') continue;
+
+		if (strcmp(word, "level") == 0) {
+			char* name = strtok(NULL, " \t\r\n");
+			if (name == NULL || strlen(name) >= LEVEL_NAME_SIZE) return fail(path, line, "the level needs a name shorter than 24 characters");
+			*levels = realloc(*levels, (*numberLevels + 1) * sizeof(levelSource));
+			l = &(*levels)[(*numberLevels)++];
+			memset(l, 0, sizeof(*l));
+			strcpy(l->name, name);
+			setGrid(l, 8, 71, 30, 8, 208); //the blocks of the original levels in a 640x480 window
+		}
+		else if (l == NULL) return fail(path, line, "blocks before the first level");
+		else if (strcmp(word, "grid") == 0) {
+			int columns;
+			double w, h, spacing, top;
+			if (sscanf(arguments(), "%d %lf %lf %lf %lf", &columns, &w, &h, &spacing, &top) != 5 || columns < 1) return fail(path, line, "grid needs columns, block width, block height, spacing and top");
+			setGrid(l, columns, w, h, spacing, top);
+		}
+		else if (strcmp(word, "row") == 0) {
+			double width = l->columns * l->blockWidth + (l->columns + 1) * l->spacing;
+			double y = l->top - (l->row + 0.5) * l->blockHeight - l->row * l->spacing;
+			int c = 0;
+			for (char* cell = strtok(NULL, " \t\r\n"); cell != NULL; cell = strtok(NULL, " \t\r\n"), c++) {
+				if (c == l->columns) return fail(path, line, "more cells than columns");
+				if (strcmp(cell, ".") == 0) continue;
+				double x = -width / 2 + (c + 1) * l->spacing + (c + 0.5) * l->blockWidth;
+				char powerup = (char)toupper((unsigned char)cell[1]);
+				if (!isdigit((unsigned char)cell[0]) || (powerup != 0 && cell[2] != 0) || !addBlock(l, x, y, l->blockWidth, l->blockHeight, cell[0] - '0', powerup)) {
+					return fail(path, line, "a cell is a strength from 1 to 5, with L, M or W after it for a powerup, or . for a gap");
+				}
+			}
+			l->row++;
+		}
+		else if (strcmp(word, "block") == 0) {
+			double x, y, w, h;
+			int strength;
+			char powerup[2] = { 0, 0 };
+			int n = sscanf(arguments(), "%lf %lf %lf %lf %d %1s", &x, &y, &w, &h, &strength, powerup);
+			if (n < 5 || !addBlock(l, x, y, w, h, strength, (char)toupper((unsigned char)powerup[0]))) return fail(path, line, "block needs x, y, width, height, a strength from 1 to 5 and L, M or W for a powerup");
+		}
+		else if (strcmp(word, "powerups") == 0) {
+			int count;
+			if (sscanf(arguments(), "%d", &count) != 1 || count < 0) return fail(path, line, "powerups needs how many go in random blocks");
+			l->randomPowerups += count;
+		}
+		else return fail(path, line, "unknown command");
+	}
+	fclose(f);
+	for (int i = 0; i < *numberLevels; i++) {
+		if ((*levels)[i].numberBlocks == 0) return fail(path, line, "a level without blocks can never be won");
+		if ((*levels)[i].numberPowerups + (*levels)[i].randomPowerups > (*levels)[i].numberBlocks) return fail(path, line, "more powerups than blocks");
+	}
+	return 0;
+}
+
+static void pad(FILE* f, long long to) {
+	while (ftell(f) < to) fputc(0, f);
+}
+
+static int writePack(const char* path, levelSource* levels, int numberLevels) {
+	FILE* f = fopen(path, "wb");
+	if (f == NULL) return fail(path, 0, "cannot write the file");
+	levelFileHeader header = { { 'B', 'K', 'L', 'V' }, LEVEL_VERSION, LEVEL_ENDIAN_MARKER, (unsigned int)numberLevels };
+	levelIndexEntry* index = calloc(numberLevels, sizeof(levelIndexEntry));
+	blockGrid* grids = calloc(numberLevels, sizeof(blockGrid));
+	long long offset = sizeof(header) + numberLevels * sizeof(levelIndexEntry);
+	for (int i = 0; i < numberLevels; i++) { //where every level goes
+		levelSource* l = &levels[i];
+		levelIndexEntry* e = &index[i];
+		blockField f = { 0 };
+		blockFieldResize(&f, l->numberBlocks, NULL);
+		for (int b = 0; b < l->numberBlocks; b++) {
+			float* v = l->x + b * 5;
+			blockFieldSet(&f, b, v[0], v[1], 2.0 * v[2], 2.0 * v[3], (int)v[4]);
+		}
+		gridBuild(&grids[i], &f, 0.0); //the same grid gameInit would make
+		blockFieldFree(&f);
+		offset = (offset + LEVEL_ALIGN - 1) / LEVEL_ALIGN * LEVEL_ALIGN;
+		e->offset = offset;
+		e->numberBlocks = l->numberBlocks;
+		e->capacity = (l->numberBlocks + 31) & ~31;
+		e->numberPowerups = l->numberPowerups + l->randomPowerups;
+		e->columns = grids[i].columns;
+		e->rows = grids[i].rows;
+		e->numberEntries = grids[i].numberEntries;
+		e->originX = grids[i].originX;
+		e->originY = grids[i].originY;
+		e->cellSize = grids[i].cellSize;
+		strcpy(e->name, l->name);
+		offset += levelDataSize(e);
+	}
+	fwrite(&header, sizeof(header), 1, f);
+	fwrite(index, sizeof(levelIndexEntry), numberLevels, f);
+
+	for (int i = 0; i < numberLevels; i++) {
+		levelSource* l = &levels[i];
+		pad(f, index[i].offset);
+		for (int field = 0; field < 5; field++) { //the blocks go in as one column per field, the padding is 0
+			for (unsigned int b = 0; b < index[i].capacity; b++) {
+				float v = b < (unsigned int)l->numberBlocks ? l->x[b * 5 + field] : 0.0f;
+				fwrite(&v, sizeof(v), 1, f);
+			}
+		}
+		int cells = grids[i].columns * grids[i].rows + 1;
+		fwrite(grids[i].cellStart, sizeof(int), cells, f);
+		fwrite(grids[i].cellCount, sizeof(int), cells, f);
+		fwrite(grids[i].cellBlocks, sizeof(int), grids[i].numberEntries, f);
+		fwrite(l->powerupBlocks, sizeof(unsigned int), l->numberPowerups, f);
+		unsigned int random = LEVEL_POWERUP_RANDOM;
+		for (int p = 0; p < l->randomPowerups; p++) fwrite(&random, sizeof(random), 1, f);
+		fwrite(l->powerupTypes, 1, l->numberPowerups, f);
+		for (int p = 0; p < l->randomPowerups; p++) fputc(0, f);
+		gridFree(&grids[i]);
+	}
+	free(grids);
+	free(index);
+	return fclose(f) == 0 ? 0 : fail(path, 0, "cannot write the file");
+}
+
+static int list(const char* path) {
+	levelPack pack;
+	if (!levelPackOpen(&pack, path)) return fail(path, 0, "not a level pack");
+	printf("%s: %d levels, %zu bytes\n", path, levelPackCount(&pack), pack.size);
+	for (int i = 0; i < levelPackCount(&pack); i++) {
+		const levelIndexEntry* e = &pack.index[i];
+		printf("%3d %-24s %8u blocks %6u powerups\n", i, e->name, e->numberBlocks, e->numberPowerups);
+	}
+	levelPackClose(&pack);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 3 && strcmp(argv[1], "-l") == 0) return list(argv[2]);
+	if (argc != 3) {
+		printf("usage: levelpack levels.txt levels.bkl   or   levelpack -l levels.bkl\n");
+		return 1;
+	}
+	levelSource* levels;
+	int numberLevels;
+	if (readSource(argv[1], &levels, &numberLevels) != 0) return 1;
+	int result = writePack(argv[2], levels, numberLevels);
+	if (result == 0) result = list(argv[2]);
+	for (int i = 0; i < numberLevels; i++) {
+		free(levels[i].x);
+		free(levels[i].powerupBlocks);
+		free(levels[i].powerupTypes);
+	}
+	free(levels);
+	return result;
+}
@@ -0,0 +1,51 @@
+// background preparation of levels, see loader.h
+
+#include "loader.h"
+
+static int prepareLevel(void* data) {
+	levelLoader* l = data;
+	if (l->pack != NULL && l->level <= levelPackCount(l->pack)) gameInitPacked(&l->prepared, l->pack, l->level - 1, l->winWidth, l->winHeight, l->seed);
+	else gameInitLevel(&l->prepared, l->level, l->winWidth, l->winHeight, l->seed);
+	atomicStore(&l->ready, 1);
+	return 0;
+}
+
+static void finish(levelLoader* l) {
+	if (!l->running) return;
+	threadJoin(l->worker);
+	l->running = false;
+}
+
+void loaderStart(levelLoader* l, const levelPack* pack, int level, int winWidth, int winHeight, unsigned int seed) {
+	finish(l);
+	l->pack = pack;
+	l->level = level;
+	l->winWidth = winWidth;
+	l->winHeight = winHeight;
+	l->seed = seed;
+	atomicStore(&l->ready, 0);
+	l->running = threadCreate(&l->worker, prepareLevel, l);
+	if (!l->running) prepareLevel(l); //no thread, so it is done here
+}
+
+bool loaderReady(levelLoader* l, int level) {
+	return l->level == level && atomicLoad(&l->ready);
+}
+
+bool loaderTake(levelLoader* l, gameState* game, int level) {
+	if (l->level != level || level == 0) return false;
+	finish(l);
+	gameState old = *game; //the old game becomes the spare one, its memory is reused for the next level
+	*game = l->prepared;
+	game->pool = old.pool;
+	l->prepared = old;
+	l->prepared.pool = NULL;
+	l->level = 0;
+	return true;
+}
+
+void loaderFree(levelLoader* l) {
+	finish(l);
+	gameFree(&l->prepared);
+	l->level = 0;
+}
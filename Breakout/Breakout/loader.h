@@ -0,0 +1,29 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+// prepares the next level on another thread (blocks, powerups and grid), so that starting it is just a swap
+
+#include <stdbool.h>
+#include "game.h"
+#include "level.h"
+
+typedef struct levelLoader
+{
+	thread worker;
+	bool running; //a worker was started and not joined yet
+	volatile int ready; //the worker is done with prepared
+	gameState prepared; //only the worker touches it until it is joined
+	const levelPack* pack; //NULL for the built in levels
+	int level; //from 1, 0 if nothing is prepared
+	int winWidth;
+	int winHeight;
+	unsigned int seed;
+} levelLoader;
+
+void loaderStart(levelLoader* l, const levelPack* pack, int level, int winWidth, int winHeight, unsigned int seed); // replaces what was prepared before
+bool loaderReady(levelLoader* l, int level); // is the level prepared and done?
+// if that level is the one being prepared it waits for it (usually it is done already) and swaps it into game, keeping its thread pool
+bool loaderTake(levelLoader* l, gameState* game, int level);
+void loaderFree(levelLoader* l);
+
+#endif
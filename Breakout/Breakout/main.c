@@ -1,5 +1,5 @@
-// on Linux compile with:   clang main.c -lm -lSDL2 -lGLU -lGL -o main
-// on Windows compile with: clang main.c -l SDL2 -l SDL2main -l Shell32 -l glu32 -l opengl32 -o main.exe -Xlinker /subsystem:console
+// on Linux compile with:   make (the sources are listed in the main target of the Makefile)
+// on Windows compile with: Breakout.vcxproj, or clang with the sources of the main target of the Makefile and -l SDL2 -l SDL2main -l Shell32 -l glu32 -l opengl32 -o main.exe -Xlinker /subsystem:console
 
 // This is the main SDL include file
 #include <SDL2/SDL.h>
@@ -12,369 +12,28 @@
 // include relevant C standard libraries
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h> // this and PI are used to create the ball
 #include <stdbool.h> // boolean type
+#include <string.h>
 #include <time.h> // for random
-#define PI 3.14159265359
-#define POWERUPNUMBER 2
-
-/* data structures */
-
-typedef struct paddle
-{
-	double x;
-	double y;
-	double width;
-	double height;
-	double speed;
-	int lives; //the 3 lives are assigned to the paddle, which represents the player
-} paddle;
-
-typedef struct powerup
-{
-	double x;
-	double y;
-	double radius;
-	double speed;
-	bool destroyed; //was the powerup destroyed by the paddle?
-} powerup;
-
-typedef struct ball
-{
-	double x;
-	double y;
-	double radius;
-	double speedX;
-	double speedY;
-} ball;
-
-typedef struct block
-{
-	double x;
-	double y;
-	double width;
-	double height;
-	bool destroyed;
-	double strength; //number of hits needed to destroy a block
-	bool power; 
-	powerup powerup;
-} block;
-
-void initializePaddle(paddle* p, double x, double y, double w, double h, double sp)
-{
-	p->x = x;
-	p->y = y;
-	p->width = w;
-	p->height = h;
-	p->speed = sp;
-	p->lives = 3;
-}
-
-powerup initializePowerup(double x, double y)
-{
-	powerup pow;
-	pow.x = x;
-	pow.y = y;
-	pow.radius = 5;
-	pow.speed = -60; //powerup falls towards the bottom
-	pow.destroyed = false;
-	return pow;
-}
-
-void initializeBall(ball* b, double x, double y, double r, double sx, double sy)
-{
-	b->x = x;
-	b->y = y;
-	b->radius = r;
-	b->speedX = sx;
-	b->speedY = sy;
-}
-
-
-void initializeBlock(block* bl, double x, double y, double w, double h,int str, bool power)
-{
-	bl->x = x;
-	bl->y = y;
-	bl->width = w;
-	bl->height = h;
-	bl->destroyed = false;
-	bl->strength = str;
-	bl->power = power;
-	if (power) bl->powerup = initializePowerup(x, y);
-}
-
-char powerupXpaddle(powerup* pow, paddle* p) { //collision detection
-	return (pow->y <= p->y + (p->height / 2.0)) &&
-		(pow->y >= p->y - (p->height / 2.0)) &&
-		(pow->x >= p->x - (p->width / 2.0)) &&
-		(pow->x <= p->x + (p->width / 2.0));
-}
-
-void updatePowerup(powerup* pow, paddle* p, double f) {
-	if (powerupXpaddle(pow, p) && !pow-> destroyed) {
-		pow->destroyed = true;
-		p->lives++; // the powerup falls and if its touched by the paddle it gives a bonus life
-	}
-	pow->y += pow->speed * f;
-}
-
-void updatePaddle(paddle* p, double f, int d, int w)
-{
-	p->x += p->speed * f * (double)d; /* calculate next position */
-
-	/* ensure the paddle does not go beyond the boundaries */
-	if (p->x + (p->width / 2.0) >= (double)(w / 2)) p->x = (double)(w / 2) - (p->width / 2.0);
-	if (p->x - (p->width / 2.0) <= (double)(w / -2)) p->x = (double)(w / -2) + (p->width / 2.0);
-}
-
-char ballXpaddle(ball* b, paddle* p) /* collision detection */
-{ 	/* return if the ball has collided with the paddle */
-	return (b->y <= p->y + (p->height / 2.0)) &&
-		(b->y >= p->y - (p->height / 2.0)) &&
-		(b->x >= p->x - (p->width / 2.0)) &&
-		(b->x <= p->x + (p->width / 2.0)); /* ball y matches the paddle */
-}
-
-char ballXblock(ball* b, block* bl) /* collision detection */
-{   /* return if the ball has collided with the block*/
-	return (!bl->destroyed) &&
-		(b->y - b->radius <= bl->y + (bl->height / 2.0)) &&
-		(b->y + b->radius >= bl->y - (bl->height / 2.0)) &&
-		(b->x + b->radius >= bl->x - (bl->width / 2)) &&
-		(b->x - b->radius <= bl->x + (bl->width / 2));
-}
-
-
-//source from "Davide Bressani" starts here
-void changeSpeed(ball* b, paddle* p) { // the ball changes direction based on how it hits the paddle to make it seem more natural, there are 4 cases
-	int width = p->width;
-	if (b->speedX > 0) {
-		if (b->x >= p->x - width / 2 && b->x < p->x) { // 1st case: if the ball arrives from the left and hits the left side of the paddle it bounces back
-			b->speedX *= -1;
-		}
-	}
-	else {
-		if (b->x <= p->x + width / 2 && b->x > p->x) { // 2nd case: if the ball arrives from the right and hits the right side of the paddle it bounces back
-			b->speedX *= -1;
-		}
-	}
-	b->speedY *= -1.0; //in every case the speedY is negative so it bounces back, in the 3rd and 4th case the ball continues travelling with the same speedX
-}
-//source from "Davide Bressani" ends here
-void changeSpeedBlock(ball* b, block* bl) { // the ball hits a block and bounces back
-	if ((b->x < bl->x - bl->width / 2 || b->x > bl->x + bl->width / 2 )) { //the ball hits the side of the block and the speedX changes
-		b->speedX *= -1.0;
-		if(!(b->y - b->radius < bl->y + bl->height / 2 || b->y + b->radius > bl->y - bl->height / 2)) b->speedY *= -1.0;
-	}
-	else { //the ball hits the bottom or top of the block and speedY changes
-		b->speedY *= -1.0;
-	}
-}
-
-void updateBall(ball* b, double f, paddle* p1, block* bl1, int numberOfBlocks, int w, int h, bool* hit)
-{
-	bool restart = false;
-	/* collision detection & resolution with scene boundaries */
-	if ((b->y - b->radius) <= -1.0 * (double)(h/2)) //if the ball hits the bottom boundary the restart is activated, the player loses a life
-	{
-		restart = true;
-	}
-	else if ((b->x - b->radius) <= -1.0 * (double)(w / 2))
-	{
-		b->x = -1.0 * (double)(w / 2) + b->radius; /* ensure the ball does not go beyond the boundaries */
-		b->speedX *= -1.0;
-	}
-	else if ((b->x + b->radius) >= (double)(w / 2))
-	{
-		b->x = (double)(w / 2) - b->radius; /* ensure the ball does not go beyond the boundaries */
-		b->speedX *= -1.0;
-	}
-	else if ((b->y + b->radius) >= (double)(h / 2))
-	{
-		b->y = (double)(h / 2) - b->radius; /* ensure the ball does not go beyond the boundaries */
-		b->speedY *= -1.0;
-	}
-
-	/* update position */
-	if (restart) { //if the ball hits the bottom it goes back to the center
-		b->x = 0.0;
-		b->y = -30.0;
-		b->speedX = 60.0;
-		b->speedY = 200.0;
-		p1->x = 0; //the paddle also goes back to the center
-		p1->lives--; //a life is removed
-		restart = false;
-	}
-	else if (!*hit){
-		if (ballXpaddle(b, p1))
-		{
-			*hit = true;
-			changeSpeed(b, p1);
-		}
-
-		for (int i = 0; i < numberOfBlocks; i++) {
-			if (ballXblock(b, bl1))
-			{
-				*hit = true;
-				bl1->strength--;
-				if (bl1->strength == 0) bl1->destroyed = true;
-				changeSpeedBlock(b, bl1);
-				break;
-			}
-			bl1++;
-		}
-
-		b->x += f * b->speedX;
-		b->y += f * b->speedY;
-	}
-	else {
-		if (!ballXpaddle(b, p1)) {
-			for (int i = 0; i < numberOfBlocks; i++) {
-				if (ballXblock(b, bl1)) { 
-					*hit = true;
-					break;
-				}
-				else {
-					*hit = false;
-				}
-				bl1++;
-			}
-		}
-		b->x += f * b->speedX;
-		b->y += f * b->speedY;
-	}
-}
-
-void drawBall(ball* b)
-{
-	GLint matrixmode = 0;
-	int i, angle;
-	glGetIntegerv(GL_MATRIX_MODE, &matrixmode); /* get current matrix mode */
-
-	glMatrixMode(GL_MODELVIEW); /* set the modelview matrix */
-	glPushMatrix(); /* store current modelview matrix */
-	glTranslated(b->x, b->y, 0.0); /* move the ball to its correct position */
-	//source based on "Eike Anderson"
-	glBegin(GL_TRIANGLE_FAN);
-	glColor3f(0.0, 1.0, 0.3);
-	glVertex2f(0.0f, 0.0f); /* centre point */
-	for (i = 0; i < 60; i++) /* circle */
-	{
-		angle = 2 * PI * i / 10; /* compute and draw triangles */
-		glVertex2f(b->radius * cos(angle), b->radius * sin(angle));
-	}
-	glVertex2f(b->radius*cos(0.0), b->radius*sin(0.0)); /* to close loop */
-	glEnd();
-
-	glPopMatrix(); /* restore previous modelview matrix */
-	glMatrixMode(matrixmode); /* set the previous matrix mode */
-}
-
-void drawPaddle(paddle* p)
-{
-	GLint matrixmode = 0;
-	glGetIntegerv(GL_MATRIX_MODE, &matrixmode); /* get current matrix mode */
-
-	glMatrixMode(GL_MODELVIEW); /* set the modelview matrix */
-	glPushMatrix(); /* store current modelview matrix */
-	glTranslated(p->x, p->y, 0.0); /* move the paddle to its correct position */
-
-	glBegin(GL_QUADS); /* draw paddle */
-	glColor3f(0.0, 1.0, 0.3);
-	glVertex3d(p->width / -2.0, p->height / 2.0, 0.0);
-	glVertex3d(p->width / 2.0, p->height / 2.0, 0.0);
-	glVertex3d(p->width / 2.0, p->height / -2.0, 0.0);
-	glVertex3d(p->width / -2.0, p->height / -2.0, 0.0);
-	glEnd();
-
-	glPopMatrix(); /* restore previous modelview matrix */
-	glMatrixMode(matrixmode); /* set the previous matrix mode */
-}
-
-void drawBlock(block* bl)
-{
-	GLfloat colourArray[5][3] = { {0.0,0.7,1.0} , {0.0,0.7,0.0}, {1.0,0.8,0.0}, {0.9,0.4,0.0}, {0.9,0.0,0.0}}; //5 different colours based on the strength
-	GLint matrixmode = 0;
-	int i = bl->strength-1;
-	glGetIntegerv(GL_MATRIX_MODE, &matrixmode); /* get current matrix mode */
-
-	glMatrixMode(GL_MODELVIEW); /* set the modelview matrix */
-	glPushMatrix(); /* store current modelview matrix */
-	if (!bl->destroyed) {
-		glTranslated(bl->x, bl->y, 0.0); /* move the block to its correct position */
-		glBegin(GL_QUADS); /* draw block */
-		glColor3fv(colourArray[i]);
-		glVertex3d(bl->width / -2.0, bl->height / 2.0, 0.0);
-		glVertex3d(bl->width / 2.0, bl->height / 2.0, 0.0);
-		glVertex3d(bl->width / 2.0, bl->height / -2.0, 0.0);
-		glVertex3d(bl->width / -2.0, bl->height / -2.0, 0.0);
-		glEnd();
-	}
-	else if (bl->power && !bl->powerup.destroyed){ //draws the powerups
-		glTranslated(bl->powerup.x, bl->powerup.y, 0.0); /* move the block to its correct position */
-		//source based on "Eike Anderson"
-		glBegin(GL_TRIANGLE_FAN);
-		glColor3f(1.0, 1.0, 1.0);
-		glVertex2f(0.0f, 0.0f); /* centre point */
-		for (int i = 0; i < 60; i++) /* circle with 10 segments */
-		{
-			int angle = 2 * PI * i / 10; /* compute and draw triangles */
-			glVertex2f(5 * cos(angle), 5 * sin(angle));
-		}
-		glVertex2f(5 * cos(0.0), 5 * sin(0.0)); /* to close loop */
-		glEnd();
-	}
-
-	glPopMatrix(); /* restore previous modelview matrix */
-	glMatrixMode(matrixmode); /* set the previous matrix mode */
-
-}
-
-void drawLives(paddle* p, int w, int h) {
-	GLint matrixmode = 0;
-	glGetIntegerv(GL_MATRIX_MODE, &matrixmode); /* get current matrix mode */
-
-	glMatrixMode(GL_MODELVIEW); /* set the modelview matrix */
-	for (int i = 0; i < p->lives; i++) {
-		glPushMatrix(); /* store current modelview matrix */
-		glTranslated(w / 2 - 20 -(15*i), h / 2 - 20, 0); // lives are shown on the top right
-		glBegin(GL_TRIANGLE_FAN);
-		glColor3f(1.0, 1.0, 1.0);
-		glVertex2f(0.0f, 0.0f); /* centre point */
-		for (int i = 0; i < 60; i++) /* circle with 10 segments */
-		{
-			int angle = 2 * PI * i / 10; /* compute and draw triangles */
-			glVertex2f(5 * cos(angle), 5 * sin(angle));
-		}
-		glVertex2f(5 * cos(0.0), 5 * sin(0.0)); /* to close loop */
-		glEnd();
-		glPopMatrix(); /* restore previous modelview matrix */
-	}
-	glMatrixMode(matrixmode); /* set the previous matrix mode */
-}
-
-void render(ball* b, paddle* p1, block* bl1, int winWidth, int winHeight, int numberBlocks)
-{
-	/* Start by clearing the framebuffer (what was drawn before) */
-	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-
-	/* Set the scene transformations */
-	glMatrixMode(GL_MODELVIEW); /* set the modelview matrix */
-	glLoadIdentity(); /* Set it to the identity (no transformations) */
-
-	/* draw the objects */
-	drawBall(b);
-	drawPaddle(p1);
-	for (int i = 0; i < numberBlocks; i++) { //draws different blocks
-		drawBlock(&bl1[i]);
-	}
-
-	drawLives(p1, winWidth, winHeight);
-
-	glFlush();
-}
-
-
+#include "game.h" // the simulation: paddle, ball, blocks and powerups
+#include "render.h" // draws the game
+#include "replay.h" // records the games with --record file, play them back with headless -p file
+#include "level.h" // the levels of the menu come from levels/levels.bkl when it is there
+#include "profile.h" // F3 or --profile file turns it on, the trace is saved when the game is closed
+#include "pacing.h" // frame times, frame limiter and latency
+#include "loader.h" // the next level is prepared on another thread while a screen is shown
+#include "stream.h" // --endless chunks plays a streamed level (0 chunks never ends) instead of the levels of the menu
+#include "snapshot.h" // F5 keeps the game as it is, F9 goes back to it (retry from here)
+#include "input.h" // the keys and the mouse with the time they happened, so every step uses them from the right moment
+#include "asset.h" // the pictures of the menu and the screens, decoded on another thread and kept in a cache
+#include "particles.h" // sparks when a block breaks, the ball hits the paddle or a powerup is caught
+#include "audio.h" // the sounds, mixed on SDL's audio thread (SDL_AUDIODRIVER=dummy for none)
+#include "text.h" // the score and the level on top, F2 or --stats 1 adds the frame rate and collision numbers at the bottom
+
+#define RESULT_SCREEN_TIME 3.0 // seconds the win and lose screens are shown
+#define STATS_INTERVAL 0.5 // seconds between two updates of the stats, so they can be read
+
+enum hudStrings { HUD_SCORE, HUD_LEVEL, HUD_FRAMES, HUD_COUNTS };
 
 void renderImage(GLuint t) //source from "Eike Anderson" starts here
 {
@@ -383,6 +42,10 @@ void renderImage(GLuint t) //source from "Eike Anderson" starts here
 	/* Set the scene transformations */
 	glMatrixMode(GL_MODELVIEW); /* set the modelview matrix */
 	glLoadIdentity(); /* Set it to the identity (no transformations) */	
+	if (t == 0) { //still loading, the screen stays black for the frame or two it takes
+		glFlush();
+		return;
+	}
 	glEnable(GL_TEXTURE_2D);
 	glBindTexture(GL_TEXTURE_2D, t);
 
@@ -397,67 +60,8 @@ void renderImage(GLuint t) //source from "Eike Anderson" starts here
 	glFlush();
 }
 //source from "Eike Anderson" ends here
-GLuint createTexture(const char* path) //source from "Eike Anderson" starts here
-{
-	GLuint TextureID = 0;
-    SDL_Surface* Surface = SDL_LoadBMP(path);
-    int mode;
-    if(Surface->format->BytesPerPixel == 4) {
-		mode = GL_RGBA;
-	}
-	else mode=GL_RGB;
-    glGenTextures(1, &TextureID);
-    glBindTexture(GL_TEXTURE_2D, TextureID);
-	glTexImage2D(GL_TEXTURE_2D, 0, mode, 640, 480, 0, mode, GL_UNSIGNED_BYTE, Surface->pixels);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	return TextureID;
-}
-//source from "Eike Anderson" ends here
-//source from "Davide Bressani" starts here
-bool appendNoDuplicates(int index, int* array, int element) { //so that the powerups do not end up in the same block
-	for (int i = 0; i < index+1; i++) {
-		if (element==array[i])return false;
-		if (array[i] == 0) {
-			array[i] = element;
-			break;
-		}
-	}
-	return true;
-}
-//source from "Davide Bressani" ends here
-void init(ball* myB, paddle* p1, int* powerupCoordArray, int numberPowerups, block* blocksArray, int numberBlocks, int blocksRows, int winWidth, int winHeight, Uint32 timer) {
-	srand(time(0));
-	for (int i = 0; i < numberPowerups; i++) {
-		int coord = rand() % (numberBlocks + 1);
-		while (!appendNoDuplicates(i, powerupCoordArray, coord)) {
-			coord = rand() % (numberBlocks + 1);
-		} // this function initializes the levels after a loss or a win
-	}
-
-	for (int r = 0; r < blocksRows; r++) { //the placing and spacing between the blocks
-		for (int c = 0; c < numberBlocks/blocksRows; c++) {
-			block block1;
-			int spacing = 8;
-
-			double blockWidth = (winWidth - (spacing * 9)) / 8;
-			double blockHeight = 30;
-			double x = (-winWidth / 2) + ((c + 1) * spacing + (c + 0.5) * blockWidth);
-			double y = (winHeight / 2) - (32 + (r + 0.5) * blockHeight + r * spacing);
-
-			bool spawn = false;
-			for (int i = 0; i < numberPowerups; i++) {
-				if (powerupCoordArray[i] == 0) break;
-				if ((r * numberBlocks / blocksRows) + c == powerupCoordArray[i]-1) {
-					spawn = true; //spawns the powerups
-					break;
-				}
-			}
-			initializeBlock(&block1, x, y, blockWidth, blockHeight, r+1, spawn);
-			blocksArray[(r * numberBlocks / blocksRows) + c] = block1;
-		}
-	}
-	/* Set up the parts of the scene that will stay the same for every frame. */
+void init(int winWidth, int winHeight) {
+	/* Set up the parts of the scene that will stay the same for every frame, once when the window is created. */
 
 	glFrontFace(GL_CCW);     /* Enforce counter clockwise face ordering (to determine front and back side) */
 	glEnable(GL_NORMALIZE);
@@ -469,24 +73,51 @@ void init(ball* myB, paddle* p1, int* powerupCoordArray, int numberPowerups, blo
 	/* Set the clear (background) colour */
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-	/* Set up the camera/viewing volume (projection matrix) */
+	/* Set up the camera/viewing volume (projection matrix), the menu, the screens and the game all use the same one */
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	gluOrtho2D(-1.0 * (GLdouble)(winWidth / 2), (GLdouble)(winWidth / 2), -1.0 * (GLdouble)(winHeight / 2), (GLdouble)(winHeight / 2));
 
 	glViewport(0, 0, winWidth, winHeight);
+}
+
+void startLevel(gameState* game, levelLoader* loader, const levelPack* pack, streamSettings* stream, int level, int winWidth, int winHeight) {
+	if (stream != NULL) { //every button of the menu plays the streamed level, a new one every time
+		stream->seed = (unsigned int)time(0);
+		gameInitStream(game, stream, winWidth, winHeight);
+		return;
+	}
+	if (loaderTake(loader, game, level)) return; //it was prepared in the background, nothing else to do
+	if (pack != NULL && level <= levelPackCount(pack)) gameInitPacked(game, pack, level - 1, winWidth, winHeight, (unsigned int)time(0));
+	else gameInitLevel(game, level, winWidth, winHeight, (unsigned int)time(0)); // this function initializes the levels after a loss or a win
+}
 
-	/* initialize the timer */
-	timer = SDL_GetTicks();
+void updateHud(textLayer* text, const gameState* game, int level, int winWidth, int winHeight) { //a string is only laid out again when its number changes
+	static const GLubyte white[4] = { 255, 255, 255, 255 };
+	char line[TEXT_LENGTH_MAX + 1];
+	snprintf(line, sizeof(line), "SCORE %d", game->score);
+	textSet(text, HUD_SCORE, line, (float)(-winWidth / 2 + 10), (float)(winHeight / 2 - 10), 2.0f, white);
+	if (game->stream != NULL) snprintf(line, sizeof(line), "ENDLESS");
+	else snprintf(line, sizeof(line), "LEVEL %d", level);
+	textSet(text, HUD_LEVEL, line, (float)(int)(-textWidth(line, 2.0f) / 2.0f), (float)(winHeight / 2 - 10), 2.0f, white);
+}
 
-	/* initialize objects */
-	initializeBall(myB, 0.0, 0.0, 5.0, 60.0, 200.0);
-	initializePaddle(p1, 0.0, -200.0, 40, 6, 150.0);
+void updateStats(textLayer* text, const framePacer* pacer, const gameState* game, const particleSystem* particles, int winWidth, int winHeight) {
+	static const GLubyte yellow[4] = { 255, 230, 77, 255 };
+	char line[TEXT_LENGTH_MAX + 1];
+	double median = pacerPercentile(pacer, 0.5);
+	snprintf(line, sizeof(line), "FPS %.0f  P99 %.1f MS", median > 0.0 ? 1.0 / median : 0.0, 1000.0 * pacerPercentile(pacer, 0.99));
+	textSet(text, HUD_FRAMES, line, (float)(-winWidth / 2 + 10), (float)(-winHeight / 2 + 24), 1.0f, yellow);
+	snprintf(line, sizeof(line), "COLLISIONS %d  BALLS %d  PARTICLES %d", game->collisionTests, game->numberBalls, particles->live);
+	textSet(text, HUD_COUNTS, line, (float)(-winWidth / 2 + 10), (float)(-winHeight / 2 + 12), 1.0f, yellow);
 }
 
 int main(int argc, char* argv[])
 {
 	int shownScreen = 0; //4 different screens, this is the first one for the levels
+	double screenEnd = 0.0; //when the win or lose screen goes back to the menu
+	int playing = 1; //the level being played, or the last one
+	levelLoader loader = { 0 };
 
     //window parameters
 	int winPosX = 100;
@@ -495,15 +126,54 @@ int main(int argc, char* argv[])
 	int winHeight = 480;
 	int go;
 
-	Uint32 timer = 0; /* animation timer (in milliseconds) */
-
-	paddle p1;
-	ball myB;
-	bool hit = false;
-	block blocksArray[100];
-	int numberBlocks;
-	int powerupCoordArray[100] = {0}; //chooses 2 random numbers, those are the blocks for the powerups
-	int p1dir = 0;
+	framePacer pacer; /* animation timer, with the resolution of the performance counter instead of milliseconds */
+	double fps = -1.0; //frame limit, -1 is the refresh rate of the screen and 0 no limit
+	bool vsync = false;
+
+	gameState game = { 0 }; //ball, paddle, blocks and powerups of the level being played
+	renderBatch batch; //vertex arrays the scene is packed into every frame
+	gameInput input = { 0 };
+	inputQueue inputs; //the events of the frame, taken by the steps they fall in
+	assetLoader assets; //the menu and the screen pictures
+	particleSystem particles;
+	textLayer hud; //score and level, and the stats
+	audioMixer audio;
+	bool stats = false; //F2 shows them
+	double statsTime = 0.0; //when they were last updated
+	double accumulator = 0.0; //time not yet simulated, the game is updated in steps of GAME_STEP seconds
+	replayWriter recorder = { 0 };
+	const char* recordPath = NULL; //every game started from the menu overwrites this file
+
+	const char* tracePath = "trace.json";
+	bool profiled = false; //was the profiler ever on?
+	streamSettings endless;
+	streamSettings* stream = NULL; //set by --endless
+	gameSnapshot retry = { 0 }; //taken with F5
+	int retryLevel = 0; //the level it was taken in, 0 for none
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "--record") == 0) recordPath = argv[i + 1];
+		else if (strcmp(argv[i], "--fps") == 0) fps = atof(argv[i + 1]);
+		else if (strcmp(argv[i], "--vsync") == 0) vsync = atoi(argv[i + 1]) != 0;
+		else if (strcmp(argv[i], "--stats") == 0) stats = atoi(argv[i + 1]) != 0;
+		else if (strcmp(argv[i], "--endless") == 0) {
+			streamDefaults(&endless);
+			endless.chunks = atoi(argv[i + 1]);
+			stream = &endless;
+		}
+		else if (strcmp(argv[i], "--profile") == 0) {
+			tracePath = argv[i + 1];
+			profileSetEnabled(true);
+			profiled = true;
+		}
+	}
+	levelPack levels;
+	const levelPack* pack = NULL; //replays only know the built in levels, so they are used when recording
+	if (stream != NULL && recordPath != NULL) {
+		printf("A streamed level cannot be recorded, --record is ignored\n");
+		recordPath = NULL;
+	}
+	if (recordPath == NULL && levelPackOpen(&levels, "levels/levels.bkl")) pack = &levels;
 
 	/* This is our initialisation phase
 
@@ -566,16 +236,44 @@ int main(int argc, char* argv[])
 		 * Draw our graphics
 	*/
 	go = 1;
-
-    GLuint texture1=createTexture("breakout_menu/levels.bmp");
-	GLuint texture2=createTexture("breakout_menu/lost2.bmp");
-    GLuint texture3=createTexture("breakout_menu/won.bmp");
+	if (vsync && SDL_GL_SetSwapInterval(-1) != 0) SDL_GL_SetSwapInterval(1); //adaptive vsync if the driver has it, it does not wait when a frame is late
+	if (!vsync) SDL_GL_SetSwapInterval(0);
+	if (fps < 0.0) { //by default no more frames than the screen can show, so the CPU can sleep in between
+		SDL_DisplayMode mode;
+		fps = SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &mode) == 0 && mode.refresh_rate > 0 ? mode.refresh_rate : 60.0;
+	}
+	pacerInit(&pacer, fps);
+	inputInit(&inputs);
+	init(winWidth, winHeight);
+	renderInit(&batch);
+	if (particlesInit(&particles, (unsigned int)time(0))) batch.particles = &particles;
+	textInit(&hud);
+	batch.text = &hud;
+	audioOpen(&audio); //without it the game is silent
+	game.pool = threadPoolCreate(0); //one worker per CPU, used when the multiball powerup makes lots of balls
+	if (stream == NULL) loaderStart(&loader, pack, 1, winWidth, winHeight, (unsigned int)time(0)); //while the menu is shown
+
+	assetInit(&assets, SDL_GL_GetProcAddress);
+	int texture1 = assetRequest(&assets, "breakout_menu/levels.bmp");
+	int texture2 = assetRequest(&assets, "breakout_menu/lost2.bmp");
+	int texture3 = assetRequest(&assets, "breakout_menu/won.bmp");
+	assetStart(&assets); //the menu comes up at once, its picture a frame or two later
     
 
 	while (go)
 	{
-		Uint32 old = timer;
-		timer = SDL_GetTicks();
+		profileFrameBegin();
+		double frameTime = pacerFrameStart(&pacer);
+		assetUpdate(&assets);
+		char report[128];
+		if (pacerReport(&pacer, report, sizeof(report))) {
+			char title[448], used[96] = "", sparks[96] = "", sound[96] = "";
+			if (inputReport(&inputs, used + 2, sizeof(used) - 2)) memcpy(used, ", ", 2);
+			if (particlesReport(&particles, sparks + 2, sizeof(sparks) - 2)) memcpy(sparks, ", ", 2);
+			if (audioReport(&audio, sound + 2, sizeof(sound) - 2)) memcpy(sound, ", ", 2);
+			snprintf(title, sizeof(title), "Breakout!!! - %s%s%s%s", report, used, sparks, sound);
+			SDL_SetWindowTitle(window, title);
+		}
 		SDL_Event incomingEvent;
 		switch (shownScreen) //a switch to change between the different screens
 		{
@@ -593,23 +291,25 @@ int main(int argc, char* argv[])
 							if (incomingEvent.button.y > 162 && incomingEvent.button.y < 235) {
 								if (incomingEvent.button.x > 112 && incomingEvent.button.x < 352) {
 									shownScreen = 1;
-									init(&myB, &p1, powerupCoordArray, 2, blocksArray, 24, 3, winWidth, winHeight, timer);
-									numberBlocks = 24;
+									playing = 1;
+									renderForget(&batch);
+									accumulator = 0.0;
 								}
 							}
 							else if (incomingEvent.button.y > 258 && incomingEvent.button.y < 330) {
 							    if (incomingEvent.button.x > 112 && incomingEvent.button.x < 352) {
 									shownScreen = 1;
-									init(&myB, &p1, powerupCoordArray, 3, blocksArray, 32, 4, winWidth, winHeight, timer);
-									numberBlocks = 32;
+									playing = 2;
+									renderForget(&batch);
+									accumulator = 0.0;
 								}
 							}
 							else if (incomingEvent.button.y > 357 && incomingEvent.button.y < 428) {
 							    if (incomingEvent.button.x > 112 && incomingEvent.button.x < 352) {
 									shownScreen = 1;
-									init(&myB, &p1, powerupCoordArray, 4, blocksArray, 40, 5, winWidth, winHeight, timer);
-									numberBlocks = 40;
-
+									playing = 3;
+									renderForget(&batch);
+									accumulator = 0.0;
 								}
 							}
 						}
@@ -618,12 +318,14 @@ int main(int argc, char* argv[])
 					break;
 					}
 				}
-				glMatrixMode(GL_PROJECTION);
-				glLoadIdentity();
-				gluOrtho2D(-1.0 * (GLdouble)(winWidth / 2), (GLdouble)(winWidth / 2), -1.0 * (GLdouble)(winHeight / 2), (GLdouble)(winHeight / 2));
-				glViewport(0, 0, winWidth, winHeight);
-				glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-				renderImage(texture1);
+				if (shownScreen == 1) {
+					startLevel(&game, &loader, pack, stream, playing, winWidth, winHeight);
+					particlesClear(&particles);
+					if (recordPath != NULL && !replayOpenWrite(&recorder, recordPath, &game, GAME_STEP)) {
+						printf("Cannot record the game to %s\n", recordPath);
+					}
+				}
+				renderImage(assetTexture(&assets, texture1));
 				SDL_GL_SwapWindow(window);
 				break;
 			}
@@ -634,8 +336,8 @@ int main(int argc, char* argv[])
 			SDL has a queue of events. We need to check for each event and then do something about it (called 'event handling').
 			The SDL_Event is the data type for the event. */
 
-			double fraction = 0.0;
 
+			PROFILE_BEGIN(eventZone, "events");
 			/* SDL_PollEvent will check if there is an event in the queue - this is the program's 'message pump'.
 			If there is nothing in the queue it will not sit and wait around for an event to come along (there are functions which do this,
 			and that can be useful too!). Instead for an empty queue it will simply return 'false' (0).
@@ -652,38 +354,64 @@ int main(int argc, char* argv[])
 					To quit we need to set our 'go' variable to false (0) so that we can escape out of the main loop. */
 					go = 0;
 					break;
-				case SDL_KEYDOWN:
+				case SDL_KEYDOWN: {
+					double time = pacerEventTime(&pacer, incomingEvent.key.timestamp);
+					pacerInput(&pacer, time);
 					switch (incomingEvent.key.keysym.sym)
 					{
 					case SDLK_RIGHT:
-						p1dir = 1;
+					case SDLK_d:
+						inputPushDirection(&inputs, time, 1);
 						break;
 					case SDLK_LEFT:
-						p1dir = -1;
+					case SDLK_a:
+						inputPushDirection(&inputs, time, -1);
 						break;
-					case SDLK_d:
-						p1dir = 1;
+					case SDLK_F2:
+						stats = !stats;
+						textClear(&hud, HUD_FRAMES);
+						textClear(&hud, HUD_COUNTS);
+						statsTime = 0.0;
 						break;
-					case SDLK_a:
-						p1dir = -1;
+					case SDLK_F3:
+						profileSetEnabled(!profileEnabled);
+						profiled = true;
+						printf("Profiler %s\n", profileEnabled ? "on" : "off");
+						break;
+					case SDLK_F5:
+						if (snapshotSave(&retry, &game)) retryLevel = playing;
+						break;
+					case SDLK_F9: //not while recording, the replay would not match any more
+						if (recordPath == NULL && retryLevel == playing && snapshotRestore(&game, &retry, NULL)) {
+							renderForget(&batch);
+							accumulator = 0.0;
+						}
 						break;
 					}
 					break;
-				case SDL_KEYUP:
+				}
+				case SDL_KEYUP: {
+					double time = pacerEventTime(&pacer, incomingEvent.key.timestamp);
+					pacerInput(&pacer, time);
 					switch (incomingEvent.key.keysym.sym)
 					{
 					case SDLK_RIGHT:
 					case SDLK_LEFT:
-						p1dir = 0;
-						break;
 					case SDLK_d:
 					case SDLK_a:
-						p1dir = 0;
+						inputPushDirection(&inputs, time, 0);
 						break;
 					case SDLK_ESCAPE: go = 0;
 						break;
 				}
 				break;
+				}
+				case SDL_MOUSEMOTION: { //the mouse takes over the paddle until a key is pressed
+					double time = pacerEventTime(&pacer, incomingEvent.motion.timestamp);
+					pacerInput(&pacer, time);
+					inputPushPointer(&inputs, time, (double)(incomingEvent.motion.x - winWidth / 2));
+					break;
+				}
 
 					/* If you want to learn more about event handling and different SDL event types, see:
 					  https://wiki.libsdl.org/SDL_Event
@@ -691,70 +419,94 @@ int main(int argc, char* argv[])
 				}
 			}
 
-			/* update timer */
-			fraction = (double)(timer - old) / 1000.0; /* calculate the frametime by finding the difference in ms from the last update/frame and divide by 1000 to get to the fraction of a second */
-			
+			PROFILE_END(eventZone);
 
-			int blocksDestroyed = 0;
-			for (int i = 0; i < numberBlocks; i++) {
-				if (blocksArray[i].destroyed) {
-					blocksDestroyed++;
-
-					if (blocksArray[i].power) updatePowerup(&(blocksArray[i].powerup), &p1, fraction);
-				}
-			}
-			if (blocksDestroyed == numberBlocks) { //if all the blocks are destroyed the win screen is shown
-				shownScreen = 3;
-				glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			/* update timer */
+			accumulator += frameTime; /* the frametime in seconds, measured with the performance counter so even very short frames are not 0 */
+			if (accumulator > 0.25) accumulator = 0.25; //after a long stall the game skips ahead instead of running hundreds of steps at once
+			PROFILE_BEGIN(simulateZone, "simulate");
+			double stepStart = pacerFrameBegan(&pacer) - accumulator; //the simulation is accumulator seconds behind the start of the frame
+			while (accumulator >= GAME_STEP && game.status == GAME_PLAYING) { /* the simulation always moves in fixed steps, independent from the frame rate */
+				renderRemember(&batch, &game);
+				inputTake(&inputs, stepStart, GAME_STEP, pacerNow(&pacer), &input); //the events that happened in the time of this step
+				gameStep(&game, &input, GAME_STEP);
+				replayRecord(&recorder, &input, &game);
+				accumulator -= GAME_STEP;
+				stepStart += GAME_STEP;
 			}
-			/* update positions */
-			updatePaddle(&p1, fraction, p1dir, winWidth); /* move paddle */
-
-			updateBall(&myB, fraction, &p1, blocksArray, numberBlocks, winWidth, winHeight, &hit); /* move ball and check collisions with the paddles */
-			if (p1.lives == 0) { //if the player finishes his lives the lose screen is shown
-				shownScreen = 2;
-				glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			PROFILE_END(simulateZone);
+			particlesEmitEvents(&particles, game.events, game.numberEvents);
+			audioPlayEvents(&audio, game.events, game.numberEvents);
+			game.numberEvents = 0;
+			particlesUpdate(&particles, (float)frameTime);
+
+			if (game.status != GAME_PLAYING) { //if all the blocks are destroyed the win screen is shown, if the player finishes his lives the lose screen
+				replayCloseWrite(&recorder, &game);
+				shownScreen = game.status == GAME_WON ? 3 : 2;
+				screenEnd = pacerNow(&pacer) + RESULT_SCREEN_TIME;
+				/* while the screen is shown the level that is most likely to come next is prepared: the next one after a win, the same one again after a loss */
+				int next = game.status == GAME_WON && playing < LEVELS_NUMBER ? playing + 1 : playing;
+				if (stream == NULL) loaderStart(&loader, pack, next, winWidth, winHeight, (unsigned int)time(0));
 			}
 			else {
+				updateHud(&hud, &game, playing, winWidth, winHeight);
+				if (stats && pacerNow(&pacer) >= statsTime + STATS_INTERVAL) {
+					updateStats(&hud, &pacer, &game, &particles, winWidth, winHeight);
+					statsTime = pacerNow(&pacer);
+				}
 				/* Render our scene. */
-				render(&myB, &p1, blocksArray, winWidth, winHeight, numberBlocks);
+				render(&batch, &game, accumulator / GAME_STEP, winWidth, winHeight); /* between the last two steps, so the motion is smooth at any frame rate */
 
 				/* This does the double-buffering page-flip, drawing the scene onto the screen. */
+				PROFILE_BEGIN(swapZone, "swap");
 				SDL_GL_SwapWindow(window);
+				pacerPresented(&pacer);
+				PROFILE_END(swapZone);
 			}
 			break;
 			}
 		case(2): //the lose screen
-			shownScreen = 0;
-			
-			glMatrixMode(GL_PROJECTION);
-			glLoadIdentity();
-			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-			gluOrtho2D(-1.0 * (GLdouble)(winWidth / 2), (GLdouble)(winWidth / 2), -1.0 * (GLdouble)(winHeight / 2), (GLdouble)(winHeight / 2));
-			glViewport(0, 0, winWidth, winHeight);
-			renderImage(texture2);
-			SDL_GL_SwapWindow(window);
-			
-			SDL_Delay(3000);
-			break;
 		case(3): //the win screen
-			shownScreen = 0;
-			glMatrixMode(GL_PROJECTION);
-			glLoadIdentity();
-			gluOrtho2D(-1.0 * (GLdouble)(winWidth / 2), (GLdouble)(winWidth / 2), -1.0 * (GLdouble)(winHeight / 2), (GLdouble)(winHeight / 2));
-			glViewport(0, 0, winWidth, winHeight);
-			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-			renderImage(texture3);
+			/* the screen stays for a few seconds, but the events keep being handled so the window can be closed and a click skips it */
+			while (SDL_PollEvent(&incomingEvent))
+			{
+				if (incomingEvent.type == SDL_QUIT) go = 0;
+				else if (incomingEvent.type == SDL_MOUSEBUTTONDOWN || (incomingEvent.type == SDL_KEYUP && incomingEvent.key.keysym.sym == SDLK_ESCAPE)) screenEnd = 0.0;
+			}
+			renderImage(assetTexture(&assets, shownScreen == 2 ? texture2 : texture3));
 			SDL_GL_SwapWindow(window);
-			SDL_Delay(3000);
+			if (pacerNow(&pacer) >= screenEnd) shownScreen = 0;
 			break;
-		break;
 		}
+		profileFrameEnd();
+		PROFILE_BEGIN(waitZone, "wait");
+		pacerWait(&pacer);
+		PROFILE_END(waitZone);
 	}
 
 	/* If we get outside the main loop, it means our user has requested we exit. */
 
 	/* Our cleanup phase, hopefully fairly self-explanatory ;) */
+	replayCloseWrite(&recorder, &game); //a game left half way is still a valid replay
+	gameFree(&game);
+	snapshotFree(&retry);
+	loaderFree(&loader);
+	if (pack != NULL) levelPackClose(&levels);
+	threadPoolDestroy(game.pool);
+	if (profiled) {
+		if (profileWriteTrace(tracePath)) printf("Profile saved to %s, open it in chrome://tracing or ui.perfetto.dev\n", tracePath);
+		profileSummary(stdout);
+	}
+	profileFree();
+	pacerSummary(&pacer, stdout);
+	inputSummary(&inputs, stdout);
+	particlesSummary(&particles, stdout);
+	particlesFree(&particles);
+	textFree(&hud);
+	audioSummary(&audio, stdout);
+	audioClose(&audio);
+	renderFree(&batch);
+	assetFree(&assets);
 	SDL_GL_DeleteContext(context);
 	SDL_DestroyWindow(window);
 	SDL_Quit();
@@ -0,0 +1,115 @@
+// frame pacing, see pacing.h
+
+#include "pacing.h"
+#include <stdlib.h>
+#include <string.h>
+
+void pacerInit(framePacer* p, double fps) {
+	memset(p, 0, sizeof(*p));
+	p->frequency = SDL_GetPerformanceFrequency();
+	p->frameStart = SDL_GetPerformanceCounter();
+	p->targetFrame = fps > 0.0 ? 1.0 / fps : 0.0;
+	p->spinMargin = PACING_SPIN_MAX / 2;
+}
+
+double pacerNow(const framePacer* p) {
+	return (double)SDL_GetPerformanceCounter() / (double)p->frequency;
+}
+
+static double since(const framePacer* p, Uint64 start, Uint64 now) {
+	return (double)(now - start) / (double)p->frequency;
+}
+
+double pacerFrameStart(framePacer* p) {
+	Uint64 now = SDL_GetPerformanceCounter();
+	double frame = since(p, p->frameStart, now);
+	p->frameStart = now;
+	p->history[p->totalFrames % PACING_HISTORY] = frame;
+	p->frames++;
+	p->elapsed += frame;
+	p->totalFrames++;
+	p->totalElapsed += frame;
+	return frame;
+}
+
+static int compareTimes(const void* a, const void* b) {
+	double x = *(const double*)a, y = *(const double*)b;
+	return x < y ? -1 : x > y;
+}
+
+double pacerPercentile(const framePacer* p, double fraction) {
+	double sorted[PACING_HISTORY];
+	int n = p->totalFrames < PACING_HISTORY ? (int)p->totalFrames : PACING_HISTORY;
+	if (n == 0) return 0.0;
+	memcpy(sorted, p->history, n * sizeof(double));
+	qsort(sorted, n, sizeof(double), compareTimes);
+	int i = (int)(fraction * n);
+	return sorted[i < n ? i : n - 1];
+}
+
+double pacerFrameBegan(const framePacer* p) {
+	return (double)p->frameStart / (double)p->frequency;
+}
+
+double pacerEventTime(const framePacer* p, Uint32 timestamp) { //SDL stamps the events in milliseconds of SDL_GetTicks, how long ago that was is the same on both clocks
+	Uint32 ticks = SDL_GetTicks();
+	double age = ticks >= timestamp ? (ticks - timestamp) / 1000.0 : 0.0;
+	return pacerNow(p) - age;
+}
+
+void pacerInput(framePacer* p, double time) {
+	Uint64 when = (Uint64)(time * (double)p->frequency);
+	if (p->inputTime == 0 || when < p->inputTime) p->inputTime = when;
+}
+
+void pacerPresented(framePacer* p) { //the swap has returned, so the frame that shows the input is on its way to the screen
+	if (p->inputTime == 0) return;
+	double latency = since(p, p->inputTime, SDL_GetPerformanceCounter());
+	p->inputTime = 0;
+	p->latencySum += latency;
+	if (latency > p->latencyWorst) p->latencyWorst = latency;
+	p->latencySamples++;
+	p->totalLatency += latency;
+	p->totalLatencySamples++;
+}
+
+void pacerWait(framePacer* p) {
+	Uint64 now = SDL_GetPerformanceCounter();
+	double work = since(p, p->frameStart, now);
+	double left = p->targetFrame - work;
+	double slept = 0.0;
+	Uint32 sleep = left > p->spinMargin ? (Uint32)((left - p->spinMargin) * 1000.0) : 0;
+	if (sleep > 0) { //give the core back for most of the wait
+		SDL_Delay(sleep);
+		Uint64 woke = SDL_GetPerformanceCounter();
+		slept = since(p, now, woke);
+		double late = slept - sleep / 1000.0;
+		if (late > p->spinMargin) p->spinMargin = late * 1.25 < PACING_SPIN_MAX ? late * 1.25 : PACING_SPIN_MAX; //this machine sleeps badly, wake up earlier
+		else p->spinMargin = p->spinMargin * 0.99 > PACING_SPIN_MIN ? p->spinMargin * 0.99 : PACING_SPIN_MIN;
+	}
+	if (left > 0.0) {
+		Uint64 end = p->frameStart + (Uint64)(p->targetFrame * (double)p->frequency);
+		while (SDL_GetPerformanceCounter() < end); //and be on time for the rest
+	}
+	double frame = since(p, p->frameStart, SDL_GetPerformanceCounter()); //the spin counts as work
+	p->busy += frame - slept;
+	p->totalBusy += frame - slept;
+}
+
+bool pacerReport(framePacer* p, char* text, int size) {
+	if (p->elapsed < 1.0) return false;
+	snprintf(text, size, "%.0f fps, %.0f%% CPU, input latency %.1f ms (worst %.1f ms)", p->frames / p->elapsed, 100.0 * p->busy / p->elapsed,
+		p->latencySamples ? 1000.0 * p->latencySum / p->latencySamples : 0.0, 1000.0 * p->latencyWorst);
+	p->frames = 0;
+	p->busy = p->elapsed = 0.0;
+	p->latencySum = p->latencyWorst = 0.0;
+	p->latencySamples = 0;
+	return true;
+}
+
+void pacerSummary(const framePacer* p, FILE* out) {
+	if (p->totalElapsed <= 0.0) return;
+	fprintf(out, "%lld frames in %.1f s: %.1f fps, main loop busy %.0f%% of the time, average input latency %.2f ms over %d inputs\n",
+		p->totalFrames, p->totalElapsed, p->totalFrames / p->totalElapsed, 100.0 * p->totalBusy / p->totalElapsed,
+		p->totalLatencySamples ? 1000.0 * p->totalLatency / p->totalLatencySamples : 0.0, p->totalLatencySamples);
+}
@@ -0,0 +1,50 @@
+#ifndef PACING_H
+#define PACING_H
+
+// frame pacing for the window: high resolution frame times, a frame limiter that sleeps most of the wait and spins
+// only the last bit of it, and the numbers to check it (frame rate, CPU use of the main loop, input to present latency)
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#define PACING_SPIN_MIN 0.0005 // the last part of the wait is spent spinning, because a sleep can wake up late.
+#define PACING_SPIN_MAX 0.004 // how long is learnt from how late the sleeps actually are, between these two
+#define PACING_HISTORY 256 // frame times kept for pacerPercentile
+
+typedef struct framePacer
+{
+	Uint64 frequency; //performance counter ticks per second
+	Uint64 frameStart;
+	double targetFrame; //seconds per frame, 0 for no limit
+	double spinMargin; //seconds before the end of the frame the sleep has to end
+	Uint64 inputTime; //when the first input not yet on screen happened, 0 if none
+	/* measured since the last report */
+	int frames;
+	double busy; //seconds of work, everything but the sleeps
+	double elapsed;
+	double latencySum;
+	double latencyWorst;
+	int latencySamples;
+	double history[PACING_HISTORY]; //the last frame times, a ring
+	/* measured since the start */
+	long long totalFrames;
+	double totalBusy;
+	double totalElapsed;
+	double totalLatency;
+	int totalLatencySamples;
+} framePacer;
+
+void pacerInit(framePacer* p, double fps); // fps 0 does not limit the frame rate
+double pacerNow(const framePacer* p); // seconds, with the performance counter resolution
+double pacerFrameStart(framePacer* p); // call it at the start of every frame, returns the seconds since the last one
+double pacerFrameBegan(const framePacer* p); // pacerNow at the last pacerFrameStart
+double pacerEventTime(const framePacer* p, Uint32 timestamp); // the time of an SDL event on the pacerNow clock
+void pacerInput(framePacer* p, double time); // an input event happened at time (pacerNow clock), the latency is measured from there
+void pacerPresented(framePacer* p); // right after SDL_GL_SwapWindow
+void pacerWait(framePacer* p); // at the end of the frame, waits until it is time for the next one
+double pacerPercentile(const framePacer* p, double fraction); // frame time in seconds of the last PACING_HISTORY frames, 0.99 for the p99
+bool pacerReport(framePacer* p, char* text, int size); // about once a second: fps, CPU and latency of the last second
+void pacerSummary(const framePacer* p, FILE* out);
+
+#endif
@@ -0,0 +1,171 @@
+// the particle pool, see particles.h
+
+#include "particles.h"
+#include "simd.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "profile.h"
+
+#define SLOT(position) ((position) & (PARTICLES_MAX - 1))
+#define PARKED 1.0e7f //the x of a dead particle that is still drawn, far outside the window so GL drops it
+
+static const unsigned char blockColour[3] = { 0, 179, 255 }; //a block breaks on its last hit, so it always has the colour of strength 1 in render.c
+static const unsigned char paddleColour[3] = { 0, 255, 77 };
+static const unsigned char powerupColours[POWERUP_TYPES][3] = { { 255, 255, 255 }, { 128, 230, 255 }, { 255, 230, 77 } };
+
+bool particlesInit(particleSystem* p, unsigned int seed) {
+	memset(p, 0, sizeof(*p));
+	float** fields[] = { &p->x, &p->y, &p->speedX, &p->speedY, &p->life, &p->fade };
+	bool ok = true;
+	for (int i = 0; i < 6; i++) ok = (*fields[i] = malloc(PARTICLES_MAX * sizeof(float))) != NULL && ok;
+	p->colour = malloc(PARTICLES_MAX * sizeof(unsigned int));
+	p->vertices = malloc(PARTICLES_MAX * 2 * sizeof(float));
+	p->colours = malloc(PARTICLES_MAX * sizeof(unsigned int));
+	if (!ok || p->colour == NULL || p->vertices == NULL || p->colours == NULL) {
+		particlesFree(p);
+		return false;
+	}
+	randomSeed(&p->rng, seed);
+	return true;
+}
+
+void particlesFree(particleSystem* p) {
+	free(p->x);
+	free(p->y);
+	free(p->speedX);
+	free(p->speedY);
+	free(p->life);
+	free(p->fade);
+	free(p->colour);
+	free(p->vertices);
+	free(p->colours);
+	memset(p, 0, sizeof(*p));
+}
+
+void particlesClear(particleSystem* p) {
+	p->oldest = p->newest;
+	p->numberVertices = 0;
+	p->live = 0;
+}
+
+static float randomUnit(particleSystem* p) { //0 to 1
+	return (float)(randomNext(&p->rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+void particlesEmit(particleSystem* p, float x, float y, int count, float speed, const unsigned char colour[3]) {
+	if (p->life == NULL) return;
+	unsigned int rgb = colour[0] | colour[1] << 8 | colour[2] << 16; //bytes in memory r, g, b, a on a little endian CPU
+	for (int k = 0; k < count; k++) {
+		if (p->newest - p->oldest == PARTICLES_MAX) { //full, the oldest makes room
+			p->oldest++;
+			p->overwritten++;
+		}
+		unsigned int i = SLOT(p->newest++);
+		float angle = 2.0f * (float)PI * randomUnit(p), v = speed * (0.3f + 0.7f * randomUnit(p)), life = PARTICLE_LIFE * (0.5f + 0.5f * randomUnit(p));
+		p->x[i] = x;
+		p->y[i] = y;
+		p->speedX[i] = v * cosf(angle);
+		p->speedY[i] = v * sinf(angle);
+		p->life[i] = life;
+		p->fade[i] = 255.0f / life;
+		p->colour[i] = rgb;
+	}
+	p->emitted += count;
+}
+
+void particlesEmitEvents(particleSystem* p, const gameEvent* events, int count) {
+	for (int i = 0; i < count; i++) {
+		const gameEvent* e = &events[i];
+		if (e->type == EVENT_BLOCK_BROKEN) particlesEmit(p, e->x, e->y, 48, 160.0f, blockColour);
+		else if (e->type == EVENT_PADDLE_HIT) particlesEmit(p, e->x, e->y, 12, 90.0f, paddleColour);
+		else if (e->type == EVENT_POWERUP_CAUGHT) particlesEmit(p, e->x, e->y, 64, 200.0f, powerupColours[e->detail]);
+	}
+}
+
+static bool moveOne(particleSystem* p, unsigned int i, float dt, float* v, unsigned int* c) {
+	p->life[i] -= dt;
+	p->speedY[i] -= PARTICLES_GRAVITY * dt;
+	p->x[i] += p->speedX[i] * dt;
+	p->y[i] += p->speedY[i] * dt;
+	bool alive = p->life[i] > 0.0f;
+	v[0] = alive ? p->x[i] : PARKED;
+	v[1] = p->y[i];
+	*c = p->colour[i] | (unsigned int)(alive ? p->life[i] * p->fade[i] : 0.0f) << 24;
+	return alive;
+}
+
+/* moves the slots from begin to end-1 and packs them after the points already packed, returns how many are alive */
+#ifdef SIMD_X86
+static const unsigned char bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+TARGET_SSE2 static int moveRange(particleSystem* p, unsigned int begin, unsigned int end, float dt) {
+	__m128 step = _mm_set1_ps(dt), fall = _mm_set1_ps(PARTICLES_GRAVITY * dt), zero = _mm_setzero_ps(), parked = _mm_set1_ps(PARKED);
+	float* v = p->vertices + 2 * p->numberVertices;
+	unsigned int* c = p->colours + p->numberVertices;
+	unsigned int i = begin;
+	int live = 0;
+	for (; i + 4 <= end; i += 4, v += 8, c += 4) {
+		__m128 life = _mm_sub_ps(_mm_loadu_ps(p->life + i), step);
+		__m128 speedY = _mm_sub_ps(_mm_loadu_ps(p->speedY + i), fall);
+		__m128 x = _mm_add_ps(_mm_loadu_ps(p->x + i), _mm_mul_ps(_mm_loadu_ps(p->speedX + i), step));
+		__m128 y = _mm_add_ps(_mm_loadu_ps(p->y + i), _mm_mul_ps(speedY, step));
+		_mm_storeu_ps(p->life + i, life);
+		_mm_storeu_ps(p->speedY + i, speedY);
+		_mm_storeu_ps(p->x + i, x);
+		_mm_storeu_ps(p->y + i, y);
+		__m128 alive = _mm_cmpgt_ps(life, zero);
+		live += bitCount[_mm_movemask_ps(alive)];
+		x = _mm_or_ps(_mm_and_ps(alive, x), _mm_andnot_ps(alive, parked));
+		_mm_storeu_ps(v, _mm_unpacklo_ps(x, y)); //x0 y0 x1 y1
+		_mm_storeu_ps(v + 4, _mm_unpackhi_ps(x, y));
+		__m128i alpha = _mm_cvttps_epi32(_mm_max_ps(_mm_mul_ps(life, _mm_loadu_ps(p->fade + i)), zero));
+		_mm_storeu_si128((__m128i*)c, _mm_or_si128(_mm_loadu_si128((const __m128i*)(p->colour + i)), _mm_slli_epi32(alpha, 24)));
+	}
+	for (; i < end; i++, v += 2, c++) live += moveOne(p, i, dt, v, c);
+	p->numberVertices += end - begin;
+	return live;
+}
+#else
+static int moveRange(particleSystem* p, unsigned int begin, unsigned int end, float dt) {
+	int live = 0;
+	for (unsigned int i = begin; i < end; i++, p->numberVertices++) live += moveOne(p, i, dt, p->vertices + 2 * p->numberVertices, p->colours + p->numberVertices);
+	return live;
+}
+#endif
+
+void particlesUpdate(particleSystem* p, float dt) {
+	PROFILE_BEGIN(zone, "particles");
+	unsigned long long start = profileNow();
+	unsigned int count = p->newest - p->oldest, first = SLOT(p->oldest);
+	unsigned int split = count < PARTICLES_MAX - first ? count : PARTICLES_MAX - first; //the ring wraps after split particles
+	p->numberVertices = 0;
+	p->live = count > 0 ? moveRange(p, first, first + split, dt) + moveRange(p, 0, count - split, dt) : 0;
+	while (p->oldest != p->newest && p->life[SLOT(p->oldest)] <= 0.0f) p->oldest++; //the dead ones at the old end go all at once
+	p->updateTime = (profileNow() - start) / 1e9;
+
+	p->totalEmitted += p->emitted;
+	p->totalOverwritten += p->overwritten;
+	p->emitted = p->overwritten = 0;
+	if (p->live > p->peak) p->peak = p->live;
+	if (p->live > p->reportPeak) p->reportPeak = p->live;
+	p->reportUpdate += p->updateTime;
+	p->reportDraw += p->drawTime;
+	p->reportFrames++;
+	PROFILE_COUNT(PROFILE_PARTICLES, p->live);
+	PROFILE_END(zone);
+}
+
+bool particlesReport(particleSystem* p, char* text, int size) {
+	if (p->totalEmitted == 0 || p->reportFrames == 0) return false;
+	snprintf(text, size, "%d particles (update %.2f ms, draw %.2f ms)", p->reportPeak,
+		1000.0 * p->reportUpdate / p->reportFrames, 1000.0 * p->reportDraw / p->reportFrames);
+	p->reportUpdate = p->reportDraw = 0.0;
+	p->reportFrames = p->reportPeak = 0;
+	return true;
+}
+
+void particlesSummary(const particleSystem* p, FILE* out) {
+	if (p->totalEmitted == 0) return;
+	fprintf(out, "%lld particles emitted, at most %d at the same time, %lld overwritten because the pool was full\n", p->totalEmitted, p->peak, p->totalOverwritten);
+}
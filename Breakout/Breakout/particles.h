@@ -0,0 +1,61 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+// the sparks of a broken block, a ball on the paddle or a caught powerup. Only for the eyes: the game never sees them and
+// they have their own random numbers, so replays and checksums stay the same.
+// Every field is its own array, all of them a ring of PARTICLES_MAX particles taken once in particlesInit: a burst goes
+// after the newest ones (over the oldest when the ring is full). Every frame they are moved 4 at a time with SSE2 and
+// packed into the point array render.c draws with a single call, the dead ones at the old end are dropped all at once
+// and the ones that died in between are parked off the screen until the end reaches them
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "game.h"
+
+#define PARTICLES_MAX 131072 // the ring, a power of two
+#define PARTICLE_LIFE 0.8f // seconds the longest lived spark of a burst lasts
+#define PARTICLE_SIZE 3.0f // pixels
+#define PARTICLES_GRAVITY 400.0f
+
+typedef struct particleSystem
+{
+	float* x;
+	float* y;
+	float* speedX;
+	float* speedY;
+	float* life; //seconds left, dead at 0 or less
+	float* fade; //255 / the life it started with, the alpha is life * fade
+	unsigned int* colour; //RGB in the first 3 bytes, the order GL reads them, the alpha byte is 0
+	unsigned int oldest; //positions in the ring, they only grow: the slot is the position & (PARTICLES_MAX - 1)
+	unsigned int newest; //one after the newest
+	unsigned long long rng;
+	/* what render.c draws, written by particlesUpdate */
+	float* vertices; //x and y of every point
+	unsigned int* colours; //RGBA of every point
+	int numberVertices;
+	/* counters */
+	int emitted; //since the last particlesUpdate
+	int overwritten; //taken from the oldest because the ring was full, since the last particlesUpdate
+	int live; //after the last particlesUpdate
+	double updateTime; //seconds the last particlesUpdate took
+	double drawTime; //seconds render spent handing them to GL in the last frame
+	int reportFrames; //since the last particlesReport
+	int reportPeak;
+	double reportUpdate;
+	double reportDraw;
+	long long totalEmitted;
+	long long totalOverwritten;
+	int peak;
+} particleSystem;
+
+bool particlesInit(particleSystem* p, unsigned int seed);
+void particlesFree(particleSystem* p);
+void particlesClear(particleSystem* p); // a new level, the old sparks go
+// count sparks flying away from x, y at up to speed, colour is RGB
+void particlesEmit(particleSystem* p, float x, float y, int count, float speed, const unsigned char colour[3]);
+void particlesEmitEvents(particleSystem* p, const gameEvent* events, int count); // a burst for every event of the game
+void particlesUpdate(particleSystem* p, float dt); // moves them and packs the points, once per frame
+bool particlesReport(particleSystem* p, char* text, int size); // for the window title, false before the first spark
+void particlesSummary(const particleSystem* p, FILE* out);
+
+#endif
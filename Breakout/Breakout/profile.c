@@ -0,0 +1,160 @@
+// frame profiler, see profile.h
+
+#include "profile.h"
+#include "thread.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+int profileEnabled = 0;
+
+static profileThread* threads[PROFILE_THREADS];
+static volatile int numberThreads = 0;
+static THREAD_LOCAL profileThread* current = NULL;
+static profileFrame* frames = NULL; //a ring of PROFILE_RING_SIZE frames, only the main thread touches it
+static long long numberFrames = 0; //frames ever profiled
+static unsigned long long frameStart = 0;
+static unsigned long long traceStart = 0;
+
+static const char* counterNames[PROFILE_COUNTERS] = { "collision tests", "hits", "draw calls", "balls", "particles" };
+
+static profileThread* thisThread(void);
+
+unsigned long long profileNow(void) {
+#ifdef _WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER now;
+	if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&now);
+	return (unsigned long long)(now.QuadPart / frequency.QuadPart * 1000000000 + now.QuadPart % frequency.QuadPart * 1000000000 / frequency.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+void profileSetEnabled(bool enabled) {
+	if (enabled && traceStart == 0) traceStart = profileNow();
+	if (enabled) thisThread();
+	profileEnabled = enabled;
+}
+
+static profileThread* thisThread(void) { //every thread gets a slot the first time it records something
+	if (current == NULL) {
+		int index = atomicAdd(&numberThreads, 1);
+		if (index >= PROFILE_THREADS) return NULL; //too many threads, the rest are not profiled
+		profileThread* t = calloc(1, sizeof(profileThread));
+		t->events = malloc(PROFILE_RING_SIZE * sizeof(profileEvent));
+		t->index = index;
+		threads[index] = t;
+		current = t;
+	}
+	return current;
+}
+
+void profileRecord(const profileZone* zone) {
+	profileThread* t = thisThread();
+	if (t == NULL) return;
+	profileEvent* e = &t->events[t->written & (PROFILE_RING_SIZE - 1)];
+	e->name = zone->name;
+	e->start = zone->start;
+	e->end = profileNow();
+	atomicStore64(&t->written, t->written + 1); //the event is complete before a reader can see it
+}
+
+void profileCount(profileCounter counter, int n) {
+	profileThread* t = thisThread();
+	if (t != NULL) t->counters[counter] += n;
+}
+
+void profileFrameBegin(void) {
+	frameStart = profileEnabled ? profileNow() : 0;
+}
+
+void profileFrameEnd(void) {
+	if (!profileEnabled || frameStart == 0) return;
+	if (frames == NULL) frames = malloc(PROFILE_RING_SIZE * sizeof(profileFrame));
+	profileFrame* f = &frames[numberFrames++ & (PROFILE_RING_SIZE - 1)];
+	f->start = frameStart;
+	f->end = profileNow();
+	int registered = atomicLoad(&numberThreads);
+	memset(f->counters, 0, sizeof(f->counters));
+	for (int i = 0; i < registered && i < PROFILE_THREADS; i++) { //the workers are done with this frame, so their counters can be taken
+		if (threads[i] == NULL) continue;
+		for (int c = 0; c < PROFILE_COUNTERS; c++) {
+			f->counters[c] += threads[i]->counters[c];
+			threads[i]->counters[c] = 0;
+		}
+	}
+}
+
+static double microseconds(unsigned long long t) {
+	return t > traceStart ? (t - traceStart) / 1000.0 : 0.0;
+}
+
+bool profileWriteTrace(const char* path) {
+	FILE* out = fopen(path, "w");
+	if (out == NULL) return false;
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Breakout\"}}");
+	int registered = atomicLoad(&numberThreads);
+	for (int i = 0; i < registered && i < PROFILE_THREADS; i++) {
+		profileThread* t = threads[i];
+		if (t == NULL) continue;
+		fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}", t->index, t->index == 0 ? "main" : "worker", t->index);
+		long long written = atomicLoad64(&t->written);
+		long long first = written > PROFILE_RING_SIZE ? written - PROFILE_RING_SIZE : 0;
+		for (long long k = first; k < written; k++) {
+			profileEvent* e = &t->events[k & (PROFILE_RING_SIZE - 1)];
+			fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", e->name, t->index, microseconds(e->start), (e->end - e->start) / 1000.0);
+		}
+	}
+	for (long long i = numberFrames > PROFILE_RING_SIZE ? numberFrames - PROFILE_RING_SIZE : 0; i < numberFrames; i++) {
+		profileFrame* f = &frames[i & (PROFILE_RING_SIZE - 1)];
+		fprintf(out, ",\n{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}", microseconds(f->start), (f->end - f->start) / 1000.0);
+		fprintf(out, ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{", microseconds(f->start));
+		for (int c = 0; c < PROFILE_COUNTERS; c++) fprintf(out, "%s\"%s\":%d", c ? "," : "", counterNames[c], f->counters[c]);
+		fprintf(out, "}}");
+	}
+	fprintf(out, "\n]}\n");
+	return fclose(out) == 0;
+}
+
+static int compareTimes(const void* a, const void* b) {
+	unsigned long long x = *(const unsigned long long*)a, y = *(const unsigned long long*)b;
+	return (x > y) - (x < y);
+}
+
+void profileSummary(FILE* out) {
+	if (numberFrames == 0) {
+		fprintf(out, "no frames were profiled\n");
+		return;
+	}
+	int kept = numberFrames < PROFILE_RING_SIZE ? (int)numberFrames : PROFILE_RING_SIZE;
+	unsigned long long* times = malloc(kept * sizeof(unsigned long long));
+	double totals[PROFILE_COUNTERS] = { 0 };
+	for (int i = 0; i < kept; i++) {
+		times[i] = frames[i].end - frames[i].start;
+		for (int c = 0; c < PROFILE_COUNTERS; c++) totals[c] += frames[i].counters[c];
+	}
+	qsort(times, kept, sizeof(unsigned long long), compareTimes);
+	fprintf(out, "%lld frames, the last %d: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, worst %.3f ms\n", numberFrames, kept, times[kept / 2] / 1e6,
+		times[kept * 9 / 10] / 1e6, times[kept * 99 / 100] / 1e6, times[kept - 1] / 1e6);
+	fprintf(out, "per frame:");
+	for (int c = 0; c < PROFILE_COUNTERS; c++) fprintf(out, "%s %.1f %s", c ? "," : "", totals[c] / kept, counterNames[c]);
+	fprintf(out, "\n");
+	free(times);
+}
+
+void profileFree(void) { //only when no other thread is recording any more
+	for (int i = 0; i < PROFILE_THREADS; i++) {
+		if (threads[i] == NULL) continue;
+		free(threads[i]->events);
+		free(threads[i]);
+		threads[i] = NULL;
+	}
+	free(frames);
+	frames = NULL;
+	numberFrames = 0;
+}
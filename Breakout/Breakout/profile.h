@@ -0,0 +1,78 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// frame profiler: timed zones and counters, written by every thread into its own ring buffer without locks,
+// then saved as a chrome://tracing (or ui.perfetto.dev) JSON file with a frame time summary.
+// It costs one test of profileEnabled per zone while it is off, compile with -DPROFILE_OFF to remove it completely.
+//
+//   PROFILE_BEGIN(zone, "render");
+//   ...
+//   PROFILE_END(zone);
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define PROFILE_RING_SIZE 65536 // zones kept per thread and frames kept in all, the oldest are overwritten
+#define PROFILE_THREADS 64
+
+typedef enum profileCounter
+{
+	PROFILE_COLLISION_TESTS, //ball against paddle or block sweeps
+	PROFILE_HITS, //blocks hit
+	PROFILE_DRAW_CALLS,
+	PROFILE_BALLS,
+	PROFILE_PARTICLES, //alive after the update
+	PROFILE_COUNTERS
+} profileCounter;
+
+typedef struct profileZone
+{
+	const char* name; //has to stay valid until the trace is written, so a string literal
+	unsigned long long start; //0 if the profiler was off when the zone started
+} profileZone;
+
+typedef struct profileEvent
+{
+	const char* name;
+	unsigned long long start;
+	unsigned long long end;
+} profileEvent;
+
+typedef struct profileThread
+{
+	profileEvent* events; //PROFILE_RING_SIZE of them
+	volatile long long written; //events ever written, only the owner thread changes it
+	volatile int counters[PROFILE_COUNTERS]; //since the last frame
+	int index;
+} profileThread;
+
+typedef struct profileFrame
+{
+	unsigned long long start;
+	unsigned long long end;
+	int counters[PROFILE_COUNTERS];
+} profileFrame;
+
+extern int profileEnabled;
+
+unsigned long long profileNow(void); // nanoseconds from an arbitrary point, monotonic
+void profileSetEnabled(bool enabled); // call it from the main thread, it becomes thread 0 of the trace
+void profileRecord(const profileZone* zone);
+void profileCount(profileCounter counter, int n);
+void profileFrameBegin(void); // call these two on the main thread around every frame
+void profileFrameEnd(void);
+bool profileWriteTrace(const char* path); // call it when the other threads are idle
+void profileSummary(FILE* out); // p50, p90, p99 and worst frame time and the average counters
+void profileFree(void); // at the end of the program, no thread can record anything after it
+
+#ifdef PROFILE_OFF
+#define PROFILE_BEGIN(zone, zoneName) (void)0
+#define PROFILE_END(zone) (void)0
+#define PROFILE_COUNT(counter, n) (void)(n)
+#else
+#define PROFILE_BEGIN(zone, zoneName) profileZone zone = { zoneName, profileEnabled ? profileNow() : 0 }
+#define PROFILE_END(zone) do { if (zone.start != 0) profileRecord(&zone); } while (0)
+#define PROFILE_COUNT(counter, n) do { if (profileEnabled) profileCount(counter, n); } while (0)
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+// software rasterizer for the observations, the same picture render.c draws but a lot smaller and without GL
+
+#include "raster.h"
+#include "simd.h"
+#include <string.h>
+#include <math.h>
+
+typedef struct rasterColour
+{
+	unsigned char rgb[48]; //the colour 16 times: an RGB span repeats every 3 pixels, so 16 pixels are these 48 bytes again and again
+	unsigned char gray;
+} rasterColour;
+
+#define GRAY(r, g, b) (unsigned char)((77 * (r) + 150 * (g) + 29 * (b)) >> 8)
+#define RGB4(r, g, b) r, g, b, r, g, b, r, g, b, r, g, b
+#define COLOUR(r, g, b) { { RGB4(r, g, b), RGB4(r, g, b), RGB4(r, g, b), RGB4(r, g, b) }, GRAY(r, g, b) }
+
+//the colours of render.c
+static const rasterColour blockColours[5] = { COLOUR(0, 179, 255), COLOUR(0, 179, 0), COLOUR(255, 204, 0), COLOUR(230, 102, 0), COLOUR(230, 0, 0) };
+static const rasterColour green = COLOUR(0, 255, 77);
+static const rasterColour white = COLOUR(255, 255, 255);
+static const rasterColour powerupColours[POWERUP_TYPES] = { COLOUR(255, 255, 255), COLOUR(128, 230, 255), COLOUR(255, 230, 77) };
+
+typedef struct rasterTarget
+{
+	unsigned char* pixels;
+	int width;
+	int height;
+	rasterFormat format;
+	float scaleX; //pixels per unit of the game
+	float scaleY;
+	float left; //the game coordinates of the top left corner of the picture
+	float top;
+} rasterTarget;
+
+size_t rasterFrameSize(int width, int height, rasterFormat format) {
+	return (size_t)width * height * format;
+}
+
+#ifdef SIMD_X86
+TARGET_SSE2 static void spanRgb(unsigned char* p, int count, const unsigned char rgb[48]) {
+	__m128i a = _mm_loadu_si128((const __m128i*)rgb), b = _mm_loadu_si128((const __m128i*)(rgb + 16)), c = _mm_loadu_si128((const __m128i*)(rgb + 32));
+	int i = 0;
+	for (; i + 16 <= count; i += 16, p += 48) {
+		_mm_storeu_si128((__m128i*)p, a);
+		_mm_storeu_si128((__m128i*)(p + 16), b);
+		_mm_storeu_si128((__m128i*)(p + 32), c);
+	}
+	memcpy(p, rgb, (count - i) * 3);
+}
+#else
+static void spanRgb(unsigned char* p, int count, const unsigned char rgb[48]) {
+	for (; count >= 16; count -= 16, p += 48) memcpy(p, rgb, 48);
+	memcpy(p, rgb, count * 3);
+}
+#endif
+
+static void span(const rasterTarget* t, int row, int x0, int x1, const rasterColour* c) { //x0 to x1 included, already clipped
+	unsigned char* p = t->pixels + ((size_t)row * t->width + x0) * t->format;
+	if (t->format == RASTER_GRAY) memset(p, c->gray, x1 - x0 + 1); //memset is already SIMD
+	else spanRgb(p, x1 - x0 + 1, c->rgb);
+}
+
+static int floorInt(float v) { //floorf is a libm call without SSE4.1, and this is done 4 times for every shape
+	int i = (int)v;
+	return i > v ? i - 1 : i;
+}
+
+/* the pixels whose centres are between a and b, at least the one a point in the middle falls in. false if that is off the picture */
+static bool pixelRange(float a, float b, int size, int* first, int* last) {
+	int i0 = -floorInt(0.5f - a), i1 = floorInt(b - 0.5f);
+	if (i1 < i0) i0 = i1 = floorInt((a + b) * 0.5f);
+	if (i0 < 0) i0 = 0;
+	if (i1 > size - 1) i1 = size - 1;
+	*first = i0;
+	*last = i1;
+	return i0 <= i1;
+}
+
+static void box(const rasterTarget* t, float x, float y, float halfWidth, float halfHeight, const rasterColour* c) {
+	int x0, x1, y0, y1;
+	if (!pixelRange((x - halfWidth - t->left) * t->scaleX, (x + halfWidth - t->left) * t->scaleX, t->width, &x0, &x1)) return;
+	if (!pixelRange((t->top - y - halfHeight) * t->scaleY, (t->top - y + halfHeight) * t->scaleY, t->height, &y0, &y1)) return;
+	for (int row = y0; row <= y1; row++) span(t, row, x0, x1, c);
+}
+
+static void disc(const rasterTarget* t, float x, float y, float radius, const rasterColour* c) { //a box for every row, as wide as the circle there
+	float cx = (x - t->left) * t->scaleX, cy = (t->top - y) * t->scaleY, rx = radius * t->scaleX, ry = radius * t->scaleY;
+	int y0, y1;
+	if (!pixelRange(cy - ry, cy + ry, t->height, &y0, &y1)) return;
+	for (int row = y0; row <= y1; row++) {
+		float dy = ry > 0.0f ? (row + 0.5f - cy) / ry : 0.0f;
+		float half = dy < 1.0f ? rx * sqrtf(1.0f - dy * dy) : 0.0f;
+		int x0, x1;
+		if (pixelRange(cx - half, cx + half, t->width, &x0, &x1)) span(t, row, x0, x1, c);
+	}
+}
+
+void rasterGame(const gameState* s, unsigned char* pixels, int width, int height, rasterFormat format) {
+	rasterTarget t;
+	t.pixels = pixels;
+	t.width = width;
+	t.height = height;
+	t.format = format;
+	t.scaleX = (float)width / s->winWidth;
+	t.scaleY = (float)height / s->winHeight;
+	t.left = -s->winWidth / 2.0f;
+	t.top = (float)s->cameraY + s->winHeight / 2.0f;
+	memset(pixels, 0, rasterFrameSize(width, height, format));
+
+	const blockField* f = &s->blocks;
+	float bottom = t.top - s->winHeight;
+	for (int w = 0; w < f->capacity / 32; w++) {
+		if (f->alive[w] == 0) continue; //32 destroyed blocks skipped at once
+		for (int i = w * 32; i < w * 32 + 32; i++) {
+			if (!BLOCK_ALIVE(f, i) || f->y[i] - f->halfHeight[i] > t.top || f->y[i] + f->halfHeight[i] < bottom) continue;
+			int strength = (int)f->strength[i];
+			box(&t, f->x[i], f->y[i], f->halfWidth[i], f->halfHeight[i], &blockColours[strength < 1 ? 0 : strength > 5 ? 4 : strength - 1]);
+		}
+	}
+	box(&t, (float)s->paddle.x, (float)s->paddle.y, (float)(s->paddle.width / 2.0), (float)(s->paddle.height / 2.0), &green);
+	for (int i = 0; i < s->numberBalls; i++) disc(&t, (float)s->balls[i].x, (float)s->balls[i].y, (float)s->balls[i].radius, &green);
+	for (int i = 0; i < s->numberPowerups; i++) {
+		const powerup* pow = &s->powerups[i];
+		disc(&t, (float)pow->x, (float)pow->y, (float)pow->radius, &powerupColours[pow->type]);
+	}
+	for (int i = 0; i < s->paddle.lives; i++) disc(&t, (float)(s->winWidth / 2 - 20 - (15 * i)), t.top - 20.0f, 5.0f, &white);
+}
@@ -0,0 +1,26 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+// observations as pictures for bots and tests: draws a game straight into a small grayscale or RGB buffer on the CPU,
+// from the game structs, with no window and no GL context. Everything is axis aligned boxes and discs, so every shape is
+// a run of horizontal spans, filled 16 bytes at a time. envRender (env.h) draws a whole batch of games on the thread pool
+
+#include "game.h"
+
+#define RASTER_ATARI_WIDTH 84 // the usual sizes for learning agents
+#define RASTER_ATARI_HEIGHT 84
+#define RASTER_SMALL_WIDTH 160
+#define RASTER_SMALL_HEIGHT 120
+
+typedef enum rasterFormat
+{
+	RASTER_GRAY = 1, //the value is the bytes per pixel
+	RASTER_RGB = 3
+} rasterFormat;
+
+size_t rasterFrameSize(int width, int height, rasterFormat format); // bytes of one picture
+/* the window of the game (winWidth x winHeight around the camera) scaled to width x height, top row first. Blocks get the
+   colour of their strength like on the screen, a shape smaller than a pixel still covers the pixel its centre is in */
+void rasterGame(const gameState* s, unsigned char* pixels, int width, int height, rasterFormat format);
+
+#endif
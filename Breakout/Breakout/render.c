@@ -0,0 +1,360 @@
+// batched renderer, it replaces the glBegin/glEnd drawing of every single object
+
+#include "render.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#define RENDER_NEAR_MAX 64 //blocks drawn again around one that was hit
+
+static const GLubyte colourArray[5][4] = { {0,179,255,255}, {0,179,0,255}, {255,204,0,255}, {230,102,0,255}, {230,0,0,255} }; //5 different colours based on the strength
+static const GLubyte green[4] = { 0, 255, 77, 255 };
+static const GLubyte white[4] = { 255, 255, 255, 255 };
+static const GLubyte powerupColours[POWERUP_TYPES][4] = { {255,255,255,255}, {128,230,255,255}, {255,230,77,255} }; //life, multiball and wide
+
+void renderInit(renderBatch* r) {
+	memset(r, 0, sizeof(*r));
+	for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
+		double angle = 2.0 * PI * i / CIRCLE_SEGMENTS;
+		r->circleTable[i][0] = (GLfloat)cos(angle);
+		r->circleTable[i][1] = (GLfloat)sin(angle);
+	}
+	r->cacheBlocks = true;
+	for (int i = 0; i < STREAM_SLOTS; i++) r->chunkInSlot[i] = -1;
+}
+
+void renderFree(renderBatch* r) {
+	free(r->quads);
+	free(r->circles);
+	free(r->circleIndices);
+	free(r->previousBalls);
+	free(r->previousPowerups);
+	free(r->chunkQuads);
+	if (r->layerTexture != 0) glDeleteTextures(1, &r->layerTexture);
+	memset(r, 0, sizeof(*r));
+}
+
+static void reserve(renderBatch* r, int quads, int circles) { //the arrays only grow, a normal frame does not allocate
+	if (quads > r->capacityQuads) {
+		r->capacityQuads = quads + quads / 2 + 16;
+		r->quads = realloc(r->quads, r->capacityQuads * 4 * sizeof(vertex));
+	}
+	if (circles > r->capacityCircles) {
+		int first = r->capacityCircles;
+		r->capacityCircles = circles + circles / 2 + 16;
+		r->circles = realloc(r->circles, r->capacityCircles * (CIRCLE_SEGMENTS + 1) * sizeof(vertex));
+		r->circleIndices = realloc(r->circleIndices, r->capacityCircles * CIRCLE_SEGMENTS * 3 * sizeof(GLuint));
+		for (int c = first; c < r->capacityCircles; c++) { //a fan of triangles around the centre
+			GLuint centre = c * (CIRCLE_SEGMENTS + 1);
+			GLuint* idx = r->circleIndices + c * CIRCLE_SEGMENTS * 3;
+			for (int s = 0; s < CIRCLE_SEGMENTS; s++) {
+				idx[s * 3] = centre;
+				idx[s * 3 + 1] = centre + 1 + s;
+				idx[s * 3 + 2] = centre + 1 + (s + 1) % CIRCLE_SEGMENTS;
+			}
+		}
+	}
+}
+
+void renderRemember(renderBatch* r, const gameState* game) {
+	int capacity = game->numberBalls > game->numberPowerups ? game->numberBalls : game->numberPowerups;
+	if (capacity > r->capacityPrevious) {
+		r->capacityPrevious = capacity + capacity / 2 + 16;
+		r->previousBalls = realloc(r->previousBalls, r->capacityPrevious * 2 * sizeof(float));
+		r->previousPowerups = realloc(r->previousPowerups, r->capacityPrevious * 2 * sizeof(float));
+	}
+	for (int i = 0; i < game->numberBalls; i++) {
+		r->previousBalls[i * 2] = (float)game->balls[i].x;
+		r->previousBalls[i * 2 + 1] = (float)game->balls[i].y;
+	}
+	for (int i = 0; i < game->numberPowerups; i++) {
+		r->previousPowerups[i * 2] = (float)game->powerups[i].x;
+		r->previousPowerups[i * 2 + 1] = (float)game->powerups[i].y;
+	}
+	r->numberPrevious = game->numberBalls;
+	r->numberPreviousPowerups = game->numberPowerups;
+	r->previousPaddle = (float)game->paddle.x;
+	r->previousCamera = (float)game->cameraY;
+	r->remembered = true;
+}
+
+void renderForget(renderBatch* r) {
+	r->remembered = false;
+	for (int i = 0; i < STREAM_SLOTS; i++) r->chunkInSlot[i] = -1; //a new streamed level reuses the slots
+}
+
+static float between(float previous, float now, float alpha) { //a jump (the ball going back to the centre) is not smoothed
+	if (fabsf(now - previous) > 20.0f) return now;
+	return previous + (now - previous) * alpha;
+}
+
+static void addQuad(renderBatch* r, float x, float y, float halfWidth, float halfHeight, const GLubyte colour[4]) {
+	vertex* v = r->quads + r->numberQuads++ * 4;
+	v[0].x = x - halfWidth; v[0].y = y + halfHeight;
+	v[1].x = x + halfWidth; v[1].y = y + halfHeight;
+	v[2].x = x + halfWidth; v[2].y = y - halfHeight;
+	v[3].x = x - halfWidth; v[3].y = y - halfHeight;
+	for (int i = 0; i < 4; i++) memcpy(v[i].colour, colour, 4);
+}
+
+static void addCircle(renderBatch* r, float x, float y, float radius, const GLubyte colour[4]) {
+	vertex* v = r->circles + r->numberCircles++ * (CIRCLE_SEGMENTS + 1);
+	v[0].x = x;
+	v[0].y = y;
+	memcpy(v[0].colour, colour, 4);
+	for (int s = 0; s < CIRCLE_SEGMENTS; s++) {
+		v[s + 1].x = x + radius * r->circleTable[s][0];
+		v[s + 1].y = y + radius * r->circleTable[s][1];
+		memcpy(v[s + 1].colour, colour, 4);
+	}
+}
+
+static void drawQuads(renderBatch* r) {
+	glVertexPointer(2, GL_FLOAT, sizeof(vertex), &r->quads[0].x);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(vertex), r->quads[0].colour);
+	glDrawArrays(GL_QUADS, 0, r->numberQuads * 4);
+	r->drawCalls++;
+}
+
+static void addBlock(renderBatch* r, const blockField* f, int i) {
+	addQuad(r, f->x[i], f->y[i], f->halfWidth[i], f->halfHeight[i], colourArray[(int)f->strength[i] - 1]);
+}
+
+/* the pixels a block covers (with one more around it for the rounding), clamped to the window */
+static bool blockPixels(const blockField* f, int i, int winWidth, int winHeight, int pixels[4]) {
+	pixels[0] = (int)floorf(f->x[i] - f->halfWidth[i]) + winWidth / 2 - 1;
+	pixels[1] = (int)floorf(f->y[i] - f->halfHeight[i]) + winHeight / 2 - 1;
+	pixels[2] = (int)ceilf(f->x[i] + f->halfWidth[i]) + winWidth / 2 + 1;
+	pixels[3] = (int)ceilf(f->y[i] + f->halfHeight[i]) + winHeight / 2 + 1;
+	if (pixels[0] < 0) pixels[0] = 0;
+	if (pixels[1] < 0) pixels[1] = 0;
+	if (pixels[2] > winWidth) pixels[2] = winWidth;
+	if (pixels[3] > winHeight) pixels[3] = winHeight;
+	return pixels[0] < pixels[2] && pixels[1] < pixels[3];
+}
+
+static void drawLayer(renderBatch* r, int winWidth, int winHeight) { //the layer texture over the whole window
+	static const GLfloat texture[8] = { 0, 0, 1, 0, 1, 1, 0, 1 };
+	GLfloat corners[8] = { -winWidth / 2, -winHeight / 2, winWidth - winWidth / 2, -winHeight / 2,
+		winWidth - winWidth / 2, winHeight - winHeight / 2, -winWidth / 2, winHeight - winHeight / 2 };
+	glDisableClientState(GL_COLOR_ARRAY);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, r->layerTexture);
+	glColor4ubv(white);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(2, GL_FLOAT, 0, corners);
+	glTexCoordPointer(2, GL_FLOAT, 0, texture);
+	glDrawArrays(GL_QUADS, 0, 4);
+	r->drawCalls++;
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisable(GL_TEXTURE_2D);
+	glEnableClientState(GL_COLOR_ARRAY);
+}
+
+static void setChunkBlock(renderBatch* r, const blockField* f, int i) { //the 4 vertices of block i in the chunk arrays
+	vertex* v = r->chunkQuads + i * 4;
+	if (!BLOCK_ALIVE(f, i)) {
+		memset(v, 0, 4 * sizeof(vertex)); //nothing is drawn for a quad with no area
+		return;
+	}
+	float x = f->x[i], y = f->y[i], halfWidth = f->halfWidth[i], halfHeight = f->halfHeight[i];
+	v[0].x = x - halfWidth; v[0].y = y + halfHeight;
+	v[1].x = x + halfWidth; v[1].y = y + halfHeight;
+	v[2].x = x + halfWidth; v[2].y = y - halfHeight;
+	v[3].x = x - halfWidth; v[3].y = y - halfHeight;
+	for (int k = 0; k < 4; k++) memcpy(v[k].colour, colourArray[(int)f->strength[i] - 1], 4);
+}
+
+/* the blocks of a streamed level, in level coordinates (the camera is already applied). A slot is built again when a new chunk
+   comes into it, otherwise only the blocks that changed are written, and the chunks out of the window are not drawn */
+static void renderChunks(renderBatch* r, gameState* game, float camera, int winHeight) {
+	const levelStream* st = game->stream;
+	blockField* f = &game->blocks;
+	if (f->count > r->capacityChunkQuads) {
+		r->capacityChunkQuads = f->count;
+		r->chunkQuads = realloc(r->chunkQuads, r->capacityChunkQuads * 4 * sizeof(vertex));
+		for (int i = 0; i < STREAM_SLOTS; i++) r->chunkInSlot[i] = -1;
+	}
+	bool all = game->numberChanged > BLOCKS_CHANGED_MAX;
+	bool built[STREAM_SLOTS] = { false };
+	r->layerBlocks = 0;
+	for (int i = st->firstLoaded; i < st->numberLoaded; i++) {
+		int slot = i % STREAM_SLOTS;
+		if (r->chunkInSlot[slot] == i && !all) continue;
+		for (int k = 0; k < st->slotCount[slot]; k++) setChunkBlock(r, f, slot * st->chunkCapacity + k);
+		r->chunkInSlot[slot] = i;
+		r->layerBlocks += st->slotCount[slot];
+		built[slot] = true;
+	}
+	for (int c = 0; c < game->numberChanged && !all; c++) {
+		int index = game->changedBlocks[c];
+		if (built[index / st->chunkCapacity]) continue;
+		setChunkBlock(r, f, index);
+		r->layerBlocks++;
+	}
+
+	glDepthMask(GL_FALSE); //behind everything, like the block layer
+	glVertexPointer(2, GL_FLOAT, sizeof(vertex), &r->chunkQuads[0].x);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(vertex), r->chunkQuads[0].colour);
+	for (int i = st->firstLoaded; i < st->numberLoaded; i++) {
+		double bottom = streamChunkBottom(i);
+		if (bottom > camera + winHeight / 2 || bottom + STREAM_CHUNK_HEIGHT < camera - winHeight / 2) continue;
+		int slot = i % STREAM_SLOTS;
+		glDrawArrays(GL_QUADS, slot * st->chunkCapacity * 4, st->slotCount[slot] * 4);
+		r->drawCalls++;
+	}
+	glDepthMask(GL_TRUE);
+	game->numberChanged = 0;
+}
+
+/* puts the blocks on the screen, drawing again only what changed since the last frame. The back buffer is clear
+   at this point, so after drawing the blocks it holds exactly the layer and the changed part is copied into the texture */
+static void renderBlocks(renderBatch* r, gameState* game, int winWidth, int winHeight) {
+	blockField* f = &game->blocks;
+	r->layerBlocks = 0;
+	glDepthMask(GL_FALSE); //the blocks are behind everything, the moving objects are drawn over them
+	if (!r->cacheBlocks) {
+		r->numberQuads = 0;
+		for (int i = 0; i < f->count; i++) if (BLOCK_ALIVE(f, i)) addBlock(r, f, i);
+		drawQuads(r);
+		r->layerBlocks = r->numberQuads;
+		glDepthMask(GL_TRUE);
+		game->numberChanged = 0;
+		return;
+	}
+
+	bool all = r->layerTexture == 0 || r->layerWidth != winWidth || r->layerHeight != winHeight || game->numberChanged > BLOCKS_CHANGED_MAX;
+	if (!all) {
+		drawLayer(r, winWidth, winHeight);
+		glEnable(GL_SCISSOR_TEST);
+		for (int c = 0; c < game->numberChanged && !all; c++) {
+			int pixels[4];
+			if (!blockPixels(f, game->changedBlocks[c], winWidth, winHeight, pixels)) continue;
+			/* clear the box and draw every block that reaches into it, the scissor keeps them inside */
+			int near[RENDER_NEAR_MAX];
+			int n = nearbyBlocks(f, &game->grid, pixels[0] - winWidth / 2, pixels[1] - winHeight / 2,
+				pixels[2] - winWidth / 2, pixels[3] - winHeight / 2, near, RENDER_NEAR_MAX);
+			if (n > RENDER_NEAR_MAX) { //tiny blocks, it is simpler to draw all of them
+				all = true;
+				break;
+			}
+			glScissor(pixels[0], pixels[1], pixels[2] - pixels[0], pixels[3] - pixels[1]);
+			glClear(GL_COLOR_BUFFER_BIT);
+			r->numberQuads = 0;
+			for (int k = 0; k < n; k++) addBlock(r, f, near[k]);
+			if (r->numberQuads > 0) drawQuads(r);
+			r->layerBlocks += r->numberQuads;
+			glBindTexture(GL_TEXTURE_2D, r->layerTexture);
+			glCopyTexSubImage2D(GL_TEXTURE_2D, 0, pixels[0], pixels[1], pixels[0], pixels[1], pixels[2] - pixels[0], pixels[3] - pixels[1]);
+		}
+		glDisable(GL_SCISSOR_TEST);
+		if (all) glClear(GL_COLOR_BUFFER_BIT);
+	}
+	if (all) {
+		if (r->layerTexture == 0) glGenTextures(1, &r->layerTexture);
+		glBindTexture(GL_TEXTURE_2D, r->layerTexture);
+		if (r->layerWidth != winWidth || r->layerHeight != winHeight) {
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, winWidth, winHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); //one texel per pixel
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			r->layerWidth = winWidth;
+			r->layerHeight = winHeight;
+		}
+		r->numberQuads = 0;
+		for (int i = 0; i < f->count; i++) if (BLOCK_ALIVE(f, i)) addBlock(r, f, i);
+		drawQuads(r);
+		r->layerBlocks = r->numberQuads;
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, winWidth, winHeight);
+	}
+	glDepthMask(GL_TRUE);
+	game->numberChanged = 0;
+}
+
+void render(renderBatch* r, gameState* game, double alpha, int winWidth, int winHeight)
+{
+	blockField* f = &game->blocks;
+	float a = (float)alpha;
+	bool smooth = r->remembered && alpha < 1.0;
+	bool smoothBalls = smooth && r->numberPrevious == game->numberBalls; //a ball was lost or split, the old ones cannot be matched
+	float camera = smooth ? between(r->previousCamera, (float)game->cameraY, a) : (float)game->cameraY; //0 unless the level is streamed
+	reserve(r, game->stream != NULL ? 1 : f->count + 1, game->numberBalls + game->numberPowerups + game->paddle.lives);
+	r->drawCalls = 0;
+
+	PROFILE_BEGIN(blocksZone, "blocks");
+	/* Start by clearing the framebuffer (what was drawn before) */
+	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+	/* Set the scene transformations */
+	glMatrixMode(GL_MODELVIEW); /* set the modelview matrix */
+	glLoadIdentity(); /* Set it to the identity (no transformations) */
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	if (game->stream != NULL) {
+		glTranslatef(0.0f, -camera, 0.0f); //the window follows the camera through the level
+		renderChunks(r, game, camera, winHeight);
+	}
+	else renderBlocks(r, game, winWidth, winHeight);
+	PROFILE_END(blocksZone);
+
+	/* pack the moving objects */
+	PROFILE_BEGIN(packZone, "pack vertices");
+	r->numberQuads = 0;
+	r->numberCircles = 0;
+	//the paddle moves with the camera, so it is kept at the same height in the window
+	addQuad(r, smooth ? between(r->previousPaddle, (float)game->paddle.x, a) : (float)game->paddle.x, camera + (float)(game->paddle.y - game->cameraY), (float)(game->paddle.width / 2.0), (float)(game->paddle.height / 2.0), green);
+	for (int i = 0; i < game->numberBalls; i++) {
+		ball* b = &game->balls[i];
+		float x = (float)b->x, y = (float)b->y;
+		if (smoothBalls) {
+			x = between(r->previousBalls[i * 2], x, a);
+			y = between(r->previousBalls[i * 2 + 1], y, a);
+		}
+		addCircle(r, x, y, (float)b->radius, green);
+	}
+	for (int i = 0; i < game->numberPowerups; i++) { //the powerups that are falling
+		powerup* pow = &game->powerups[i];
+		float y = (float)pow->y;
+		//one that left takes the place of the last one, so a powerup is only smoothed if it is still where it was
+		if (smooth && i < r->numberPreviousPowerups && r->previousPowerups[i * 2] == (float)pow->x) y = between(r->previousPowerups[i * 2 + 1], y, a);
+		addCircle(r, (float)pow->x, y, (float)pow->radius, powerupColours[pow->type]);
+	}
+	for (int i = 0; i < game->paddle.lives; i++) { // lives are shown on the top right
+		addCircle(r, (float)(winWidth / 2 - 20 - (15 * i)), camera + (float)(winHeight / 2 - 20), 5.0f, white);
+	}
+	PROFILE_END(packZone);
+
+	PROFILE_BEGIN(drawZone, "draw");
+	/* draw them with one call per primitive type */
+	drawQuads(r);
+
+	glVertexPointer(2, GL_FLOAT, sizeof(vertex), &r->circles[0].x);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(vertex), r->circles[0].colour);
+	glDrawElements(GL_TRIANGLES, r->numberCircles * CIRCLE_SEGMENTS * 3, GL_UNSIGNED_INT, r->circleIndices);
+	r->drawCalls++;
+	if (r->particles != NULL && r->particles->numberVertices > 0) { //over the blocks and behind the balls, they fade out
+		particleSystem* p = r->particles;
+		unsigned long long start = profileNow();
+		glDepthMask(GL_FALSE);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glPointSize(PARTICLE_SIZE);
+		glVertexPointer(2, GL_FLOAT, 0, p->vertices);
+		glColorPointer(4, GL_UNSIGNED_BYTE, 0, p->colours);
+		glDrawArrays(GL_POINTS, 0, p->numberVertices);
+		r->drawCalls++;
+		glDisable(GL_BLEND);
+		glDepthMask(GL_TRUE);
+		p->drawTime = (profileNow() - start) / 1e9;
+	}
+	else if (r->particles != NULL) r->particles->drawTime = 0.0;
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	if (r->text != NULL) {
+		glLoadIdentity(); //the HUD stays in the window when the camera moves
+		if (textDraw(r->text)) r->drawCalls++;
+	}
+
+	glFlush();
+	PROFILE_COUNT(PROFILE_DRAW_CALLS, r->drawCalls);
+	PROFILE_END(drawZone);
+}
@@ -0,0 +1,72 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+// batched renderer: every frame the whole scene is packed into two vertex arrays,
+// one for the quads (blocks and paddle) and one for the circles (balls, powerups and lives), and drawn with one call each.
+// The blocks only change when they are hit, so they are drawn once into a texture (the block layer) and only the
+// blocks that were hit are drawn again; a frame puts the layer on the screen with one quad and the moving objects on top.
+// A streamed level scrolls, so the layer does not work there: every loaded chunk keeps its own vertex array instead,
+// built when the chunk comes in and patched when one of its blocks is hit, and drawn with one call.
+// The particles go over everything as points, with one more call, and the HUD text over them with one more
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <stdbool.h>
+#include "game.h"
+#include "stream.h"
+#include "particles.h"
+#include "text.h"
+
+#define CIRCLE_SEGMENTS 16
+
+typedef struct vertex
+{
+	GLfloat x;
+	GLfloat y;
+	GLubyte colour[4];
+} vertex;
+
+typedef struct renderBatch
+{
+	GLfloat circleTable[CIRCLE_SEGMENTS][2]; //cos and sin around the circle, computed once
+	vertex* quads; //4 vertices per quad
+	int numberQuads;
+	int capacityQuads;
+	vertex* circles; //centre and then the rim, CIRCLE_SEGMENTS+1 vertices per circle
+	GLuint* circleIndices; //the triangles of every circle, they only change when the capacity grows
+	int numberCircles;
+	int capacityCircles;
+	int drawCalls; //in the last frame
+	/* where the moving objects were before the last gameStep, the frame is drawn in between */
+	float* previousBalls; //x and y of every ball
+	int numberPrevious;
+	int capacityPrevious;
+	float* previousPowerups; //x and y of every falling powerup
+	int numberPreviousPowerups;
+	float previousPaddle;
+	float previousCamera;
+	bool remembered; //false until renderRemember is called for the game being played
+	/* the block layer, a copy of the screen with only the blocks on it */
+	bool cacheBlocks; //false draws every block every frame like before
+	GLuint layerTexture;
+	int layerWidth; //the window size the layer was drawn for
+	int layerHeight;
+	int layerBlocks; //blocks drawn again in the last frame
+	/* the chunks of a streamed level, slot by slot like in the game */
+	vertex* chunkQuads; //4 vertices for every block of every slot, a destroyed block has no size
+	int capacityChunkQuads;
+	int chunkInSlot[STREAM_SLOTS]; //the chunk the vertices of the slot were built for, -1 for none
+	particleSystem* particles; //NULL for no particles, particlesUpdate packs their points before the frame
+	textLayer* text; //the HUD, NULL for none
+} renderBatch;
+
+void renderInit(renderBatch* r); // call it once there is a GL context
+void renderFree(renderBatch* r);
+void renderRemember(renderBatch* r, const gameState* game); // call it before every gameStep
+void renderForget(renderBatch* r); // a new game started, there is nothing to interpolate from
+// alpha is how far the time of the frame is between the last two steps, 1 draws the game as it is now
+void render(renderBatch* r, gameState* game, double alpha, int winWidth, int winHeight);
+
+#endif
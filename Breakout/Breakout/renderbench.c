@@ -0,0 +1,189 @@
+// benchmark for the renderer: frame time against the number of blocks, balls and particles, drawn into a hidden window
+// compile with: make renderbench, the sources it needs are listed in the Makefile
+// usage: renderbench [-f frames] [-j save the results as JSON] [-c compare with a saved JSON] [-x tolerance in %]
+// The numbers depend on the GPU and its driver, to compare machines (or a build machine with the kiosks) run it on Mesa's
+// software renderer, with no display needed: SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe ./renderbench
+
+#include <SDL2/SDL.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "game.h"
+#include "render.h"
+#include "results.h"
+
+#define BENCH_WIDTH 640
+#define BENCH_HEIGHT 480
+
+void buildScene(gameState* game, int numberBlocks, int numberBalls) { //numberBlocks in the top half of the window and numberBalls below them
+	int columns = (int)ceil(sqrt(numberBlocks * 2.0)), rows = (numberBlocks + columns - 1) / columns;
+	double width = (double)BENCH_WIDTH / columns, height = (BENCH_HEIGHT / 2.0) / rows;
+	game->extraBalls = numberBalls - 1;
+	gameReserve(game, numberBlocks, 0, false);
+	blockFieldResize(&game->blocks, numberBlocks, &game->arena);
+	for (int i = 0; i < numberBlocks; i++) {
+		int r = i / columns, c = i % columns;
+		blockFieldSet(&game->blocks, i, -BENCH_WIDTH / 2.0 + (c + 0.5) * width, BENCH_HEIGHT / 2.0 - (r + 0.5) * height, width * 0.8, height * 0.8, 1 + r % 5);
+	}
+	gridBuild(&game->grid, &game->blocks, 0.0);
+	game->winWidth = BENCH_WIDTH;
+	game->winHeight = BENCH_HEIGHT;
+	gameStart(game, BENCH_WIDTH, BENCH_HEIGHT);
+	for (int i = 1; i < numberBalls; i++) {
+		gameSpawnBall(game, -300.0 + (i * 37 % 600), -200.0 + (i * 13 % 180), 150.0 + i % 100, 200.0 + i % 50);
+	}
+}
+
+int compareFrames(const void* a, const void* b) {
+	double x = *(const double*)a, y = *(const double*)b;
+	return x < y ? -1 : x > y;
+}
+
+void benchScene(renderBatch* batch, int numberBlocks, int numberBalls, bool cacheBlocks, int frames) {
+	gameState game = { 0 };
+	gameInput input = { 0 };
+	double* times = malloc(frames * sizeof(double));
+	double frequency = (double)SDL_GetPerformanceFrequency();
+	buildScene(&game, numberBlocks, numberBalls);
+	renderInit(batch);
+	batch->cacheBlocks = cacheBlocks;
+	for (int i = -30; i < frames; i++) { //the first frames fill the block layer and warm up the driver
+		renderRemember(batch, &game);
+		input.p1dir = game.balls[0].x > game.paddle.x ? 1 : -1;
+		gameStep(&game, &input, GAME_STEP);
+		Uint64 start = SDL_GetPerformanceCounter();
+		render(batch, &game, 0.5, BENCH_WIDTH, BENCH_HEIGHT);
+		glFinish(); //the time until the picture is really done, not until the commands are queued
+		if (i >= 0) times[i] = (SDL_GetPerformanceCounter() - start) / frequency * 1000.0;
+	}
+	double sum = 0.0;
+	for (int i = 0; i < frames; i++) sum += times[i];
+	qsort(times, frames, sizeof(double), compareFrames);
+	double mean = sum / frames, p99 = times[(int)(frames * 0.99)];
+	printf("%8d blocks %7d balls  block layer %-3s  %8.3f ms/frame  p99 %8.3f ms  %d draw calls\n", numberBlocks, game.numberBalls,
+		cacheBlocks ? "on" : "off", mean, p99, batch->drawCalls);
+	char name[64];
+	snprintf(name, sizeof(name), "render/%d blocks/%d balls/%s", numberBlocks, numberBalls, cacheBlocks ? "layer" : "nolayer");
+	resultAdd(name, mean, "ms", true);
+	renderFree(batch);
+	gameFree(&game);
+	free(times);
+}
+
+void benchParticles(renderBatch* batch, int numberParticles, int frames) { //the sparks are topped up to numberParticles every frame, like a game breaking blocks all the time
+	gameState game = { 0 };
+	particleSystem particles;
+	double* times = malloc(frames * sizeof(double));
+	double frequency = (double)SDL_GetPerformanceFrequency(), update = 0.0;
+	static const unsigned char colour[3] = { 0, 179, 255 };
+	buildScene(&game, 40, 1);
+	renderInit(batch);
+	if (!particlesInit(&particles, 1)) {
+		printf("no memory for the particles\n");
+		free(times);
+		return;
+	}
+	batch->particles = &particles;
+	for (int i = -30; i < frames; i++) {
+		Uint64 start = SDL_GetPerformanceCounter();
+		for (int k = 0; particles.live + particles.emitted < numberParticles; k++) { //bursts over the whole window
+			particlesEmit(&particles, (float)((k * 97 + i * 31) % BENCH_WIDTH - BENCH_WIDTH / 2), (float)((k * 61 + i * 17) % BENCH_HEIGHT - BENCH_HEIGHT / 2), 48, 160.0f, colour);
+		}
+		particlesUpdate(&particles, 1.0f / 60.0f);
+		render(batch, &game, 1.0, BENCH_WIDTH, BENCH_HEIGHT);
+		glFinish();
+		if (i >= 0) {
+			times[i] = (SDL_GetPerformanceCounter() - start) / frequency * 1000.0;
+			update += particles.updateTime * 1000.0;
+		}
+	}
+	double sum = 0.0;
+	for (int i = 0; i < frames; i++) sum += times[i];
+	qsort(times, frames, sizeof(double), compareFrames);
+	double mean = sum / frames, p99 = times[(int)(frames * 0.99)];
+	printf("%8d particles  %8.3f ms/frame  p99 %8.3f ms  update %6.3f ms  %d draw calls\n", particles.live, mean, p99, update / frames, batch->drawCalls);
+	char name[64];
+	snprintf(name, sizeof(name), "render/%d particles", numberParticles);
+	resultAdd(name, mean, "ms", true);
+	snprintf(name, sizeof(name), "render/%d particles/update", numberParticles);
+	resultAdd(name, update / frames, "ms", true);
+	renderFree(batch);
+	particlesFree(&particles);
+	gameFree(&game);
+	free(times);
+}
+
+int main(int argc, char* argv[])
+{
+	int frames = 300;
+	const char* jsonPath = NULL;
+	const char* baselinePath = NULL;
+	double tolerance = RESULTS_TOLERANCE;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-f") == 0) frames = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-j") == 0) jsonPath = argv[i + 1];
+		else if (strcmp(argv[i], "-c") == 0) baselinePath = argv[i + 1];
+		else if (strcmp(argv[i], "-x") == 0) tolerance = atof(argv[i + 1]) / 100.0;
+	}
+	if (frames < 1) frames = 1;
+
+	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+		printf("cannot initialise SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 1);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
+	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 16);
+	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	SDL_Window* window = SDL_CreateWindow("renderbench", 0, 0, BENCH_WIDTH, BENCH_HEIGHT, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	SDL_GLContext context = window != NULL ? SDL_GL_CreateContext(window) : NULL;
+	if (context == NULL) {
+		printf("cannot create an OpenGL context: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_GL_SetSwapInterval(0);
+	printf("OpenGL %s on %s\n", (const char*)glGetString(GL_VERSION), (const char*)glGetString(GL_RENDERER));
+
+	/* the same state as the game sets up in init() */
+	glShadeModel(GL_FLAT);
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(-BENCH_WIDTH / 2, BENCH_WIDTH / 2, -BENCH_HEIGHT / 2, BENCH_HEIGHT / 2, -1.0, 1.0);
+	glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+
+	renderBatch batch;
+	int blocks[] = { 40, 400, 4000, 40000 };
+	int balls[] = { 1, 100, 1000, 10000 };
+	printf("\nframe time against the number of blocks\n");
+	for (int i = 0; i < 4; i++) {
+		benchScene(&batch, blocks[i], 1, true, frames);
+		benchScene(&batch, blocks[i], 1, false, frames);
+	}
+	printf("\nframe time against the number of balls\n");
+	for (int i = 0; i < 4; i++) benchScene(&batch, 40, balls[i], true, frames);
+	int sparks[] = { 1000, 10000, 100000 };
+	printf("\nframe time against the number of particles\n");
+	for (int i = 0; i < 3; i++) benchParticles(&batch, sparks[i], frames);
+
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	if (jsonPath != NULL) {
+		if (resultsWrite(jsonPath, "renderbench")) printf("\nresults saved to %s\n", jsonPath);
+		else printf("\ncannot write %s\n", jsonPath);
+	}
+	if (baselinePath != NULL) {
+		int regressions = resultsCompare(baselinePath, tolerance, stdout);
+		if (regressions < 0) printf("cannot read the baseline %s\n", baselinePath);
+		return regressions == 0 ? 0 : 1;
+	}
+	return 0;
+}
@@ -0,0 +1,233 @@
+// recording and playback of games, see replay.h for the format
+
+#include "replay.h"
+#include <string.h>
+
+static const char replayMagic[4] = { 'B', 'K', 'R', 'P' };
+
+/* everything is written little endian one byte at a time, so the files work on any machine */
+
+static void writeU32(FILE* f, unsigned int v) {
+	for (int i = 0; i < 4; i++) fputc((v >> (8 * i)) & 0xff, f);
+}
+
+static void writeU64(FILE* f, unsigned long long v) {
+	for (int i = 0; i < 8; i++) fputc((int)((v >> (8 * i)) & 0xff), f);
+}
+
+static void writeVarint(FILE* f, unsigned long long v) {
+	while (v >= 0x80) {
+		fputc((int)(v & 0x7f) | 0x80, f);
+		v >>= 7;
+	}
+	fputc((int)v, f);
+}
+
+static bool readU32(FILE* f, unsigned int* v) {
+	*v = 0;
+	for (int i = 0; i < 4; i++) {
+		int c = fgetc(f);
+		if (c == EOF) return false;
+		*v |= (unsigned int)c << (8 * i);
+	}
+	return true;
+}
+
+static bool readU64(FILE* f, unsigned long long* v) {
+	*v = 0;
+	for (int i = 0; i < 8; i++) {
+		int c = fgetc(f);
+		if (c == EOF) return false;
+		*v |= (unsigned long long)c << (8 * i);
+	}
+	return true;
+}
+
+static bool readVarint(FILE* f, unsigned long long* v) {
+	*v = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		int c = fgetc(f);
+		if (c == EOF) return false;
+		*v |= (unsigned long long)(c & 0x7f) << shift;
+		if (!(c & 0x80)) return true;
+	}
+	return false;
+}
+
+static void writeRecord(replayWriter* w, replayRecordType type) { //the type goes in the low 2 bits of the distance
+	writeVarint(w->file, (unsigned long long)(w->steps - w->lastRecord) << 2 | type);
+	w->lastRecord = w->steps;
+}
+
+bool replayOpenWrite(replayWriter* w, const char* path, const gameState* s, double step) {
+	memset(w, 0, sizeof(*w));
+	w->file = fopen(path, "wb");
+	if (w->file == NULL) return false;
+	w->checksumInterval = REPLAY_CHECKSUM_INTERVAL;
+	unsigned long long stepBits;
+	memcpy(&stepBits, &step, sizeof(step));
+
+	fwrite(replayMagic, 1, 4, w->file);
+	writeU32(w->file, GAME_FIXED_POINT ? REPLAY_VERSION | REPLAY_FIXED : REPLAY_VERSION);
+	writeU32(w->file, s->seed);
+	writeU32(w->file, (unsigned int)s->level);
+	writeU64(w->file, stepBits);
+	writeU32(w->file, (unsigned int)s->winWidth);
+	writeU32(w->file, (unsigned int)s->winHeight);
+	writeU32(w->file, w->checksumInterval);
+	return true;
+}
+
+void replayRecord(replayWriter* w, const gameInput* in, const gameState* s) {
+	if (w->file == NULL) return;
+	if (in->p1dir != w->lastDir) { //the input of this step, it stays the same until the next input record
+		writeRecord(w, REPLAY_INPUT);
+		fputc(in->p1dir & 0xff, w->file);
+		w->lastDir = in->p1dir;
+	}
+	if (in->numberChanges > 0 || in->pointer != w->lastPointer || (in->pointer && in->pointerX != w->lastPointerX)) {
+		writeRecord(w, REPLAY_STEP_INPUT); //the number of changes and the mouse bit, the changes, and where the mouse is if it is used
+		fputc(in->numberChanges | (in->pointer ? 0x80 : 0), w->file);
+		for (int k = 0; k < in->numberChanges; k++) {
+			fputc(in->changeAt[k], w->file);
+			fputc(in->changeDir[k] & 0xff, w->file);
+		}
+		if (in->pointer) {
+			unsigned long long xBits;
+			memcpy(&xBits, &in->pointerX, sizeof(xBits));
+			writeU64(w->file, xBits);
+		}
+		if (in->numberChanges > 0) w->lastDir = in->changeDir[in->numberChanges - 1]; //where the next step starts
+		w->lastPointer = in->pointer;
+		w->lastPointerX = in->pointerX;
+	}
+	w->steps++;
+	if (w->steps % w->checksumInterval == 0) {
+		writeRecord(w, REPLAY_CHECKSUM);
+		writeU32(w->file, gameChecksum(s));
+	}
+}
+
+void replayCloseWrite(replayWriter* w, const gameState* s) {
+	if (w->file == NULL) return;
+	writeRecord(w, REPLAY_END);
+	writeU32(w->file, gameChecksum(s));
+	fclose(w->file);
+	w->file = NULL;
+}
+
+static bool readRecord(replayReader* r) { //reads the next record ahead, false if the file is cut or wrong
+	unsigned long long v;
+	if (!readVarint(r->file, &v)) return false;
+	r->nextType = (replayRecordType)(v & 3);
+	r->nextRecord += (long long)(v >> 2);
+	switch (r->nextType) {
+	case REPLAY_INPUT: {
+		int c = fgetc(r->file);
+		if (c == EOF) return false;
+		r->nextDir = (signed char)c;
+		return true;
+	}
+	case REPLAY_STEP_INPUT: {
+		gameInput* in = &r->nextStepInput;
+		int c = fgetc(r->file);
+		if (c == EOF || (c & 0x7f) > INPUT_CHANGES_MAX) return false;
+		in->numberChanges = c & 0x7f;
+		in->pointer = (c & 0x80) != 0;
+		for (int k = 0; k < in->numberChanges; k++) {
+			int at = fgetc(r->file), dir = fgetc(r->file);
+			if (at == EOF || dir == EOF) return false;
+			in->changeAt[k] = (unsigned char)at;
+			in->changeDir[k] = (signed char)dir;
+		}
+		unsigned long long xBits;
+		if (in->pointer && !readU64(r->file, &xBits)) return false;
+		if (in->pointer) memcpy(&in->pointerX, &xBits, sizeof(in->pointerX));
+		return true;
+	}
+	case REPLAY_CHECKSUM:
+	case REPLAY_END:
+		return readU32(r->file, &r->nextChecksum);
+	default:
+		return false;
+	}
+}
+
+bool replayOpenRead(replayReader* r, const char* path) {
+	memset(r, 0, sizeof(*r));
+	r->file = fopen(path, "rb");
+	if (r->file == NULL) return false;
+	char magic[4];
+	unsigned int level, winWidth, winHeight;
+	unsigned long long stepBits;
+	replayHeader* h = &r->header;
+	bool ok = fread(magic, 1, 4, r->file) == 4 && memcmp(magic, replayMagic, 4) == 0
+		&& readU32(r->file, &h->version) && (h->version & ~REPLAY_FIXED) >= REPLAY_VERSION_OLDEST && (h->version & ~REPLAY_FIXED) <= REPLAY_VERSION
+		&& readU32(r->file, &h->seed) && readU32(r->file, &level) && readU64(r->file, &stepBits)
+		&& readU32(r->file, &winWidth) && readU32(r->file, &winHeight) && readU32(r->file, &h->checksumInterval)
+		&& level >= 1 && level <= LEVELS_NUMBER;
+	if (!ok) {
+		fclose(r->file);
+		r->file = NULL;
+		return false;
+	}
+	r->dataStart = ftell(r->file);
+	h->fixedPoint = (h->version & REPLAY_FIXED) != 0;
+	h->level = (int)level;
+	memcpy(&h->step, &stepBits, sizeof(h->step));
+	h->winWidth = (int)winWidth;
+	h->winHeight = (int)winHeight;
+	return true;
+}
+
+void replayStart(replayReader* r, gameState* s) {
+	gameInitLevel(s, r->header.level, r->header.winWidth, r->header.winHeight, r->header.seed);
+	r->steps = 0;
+	r->nextRecord = 0;
+	memset(&r->input, 0, sizeof(r->input));
+	r->mismatchStep = -1;
+	fseek(r->file, r->dataStart, SEEK_SET);
+	if (!readRecord(r)) r->nextRecord = -1;
+}
+
+replayResult replayStep(replayReader* r, gameState* s) {
+	if (r->nextRecord < 0) return REPLAY_BROKEN;
+	if (r->nextType == REPLAY_END && r->nextRecord == r->steps) {
+		if (gameChecksum(s) != r->nextChecksum) {
+			r->mismatchStep = r->steps;
+			return REPLAY_MISMATCH;
+		}
+		return REPLAY_FINISHED;
+	}
+	if (r->nextType == REPLAY_INPUT && r->nextRecord == r->steps) {
+		r->input.p1dir = r->nextDir;
+		if (!readRecord(r)) r->nextRecord = -1;
+	}
+	r->input.numberChanges = 0;
+	if (r->nextType == REPLAY_STEP_INPUT && r->nextRecord == r->steps) { //the mouse stays as it is until the next one
+		r->input.numberChanges = r->nextStepInput.numberChanges;
+		memcpy(r->input.changeAt, r->nextStepInput.changeAt, sizeof(r->input.changeAt));
+		memcpy(r->input.changeDir, r->nextStepInput.changeDir, sizeof(r->input.changeDir));
+		r->input.pointer = r->nextStepInput.pointer;
+		if (r->input.pointer) r->input.pointerX = r->nextStepInput.pointerX;
+		if (!readRecord(r)) r->nextRecord = -1;
+	}
+
+	gameStep(s, &r->input, r->header.step);
+	if (r->input.numberChanges > 0) r->input.p1dir = r->input.changeDir[r->input.numberChanges - 1];
+	r->steps++;
+
+	if (r->nextRecord == r->steps && r->nextType == REPLAY_CHECKSUM) {
+		if (gameChecksum(s) != r->nextChecksum) {
+			r->mismatchStep = r->steps;
+			return REPLAY_MISMATCH;
+		}
+		if (!readRecord(r)) r->nextRecord = -1;
+	}
+	return REPLAY_OK;
+}
+
+void replayCloseRead(replayReader* r) {
+	if (r->file != NULL) fclose(r->file);
+	r->file = NULL;
+}
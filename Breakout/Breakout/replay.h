@@ -0,0 +1,74 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// replays: the seed, the level and the input of the player are enough to play a whole game again, because the
+// simulation is deterministic. The file is a small header and then a list of records:
+//   - input: the paddle direction changed, written only when it changes
+//   - step input: what changed inside a step (version 4): the direction changes with their times, and the mouse
+//   - checksum: gameChecksum every checksumInterval steps, so playback can tell exactly where it went different
+//   - end: the number of steps and the checksum at the end
+// every record starts with the number of steps since the previous one as a varint (7 bits per byte), so a whole game is a few KB
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "game.h"
+
+#define REPLAY_VERSION 4
+#define REPLAY_VERSION_OLDEST 3 // version 3 had no step input records, it plays back the same
+#define REPLAY_FIXED 0x100 //in the version of a replay recorded by the fixed point build (see fixed.h), it does not play back in the other one
+#define REPLAY_CHECKSUM_INTERVAL 120 //once a second of game time
+
+typedef enum replayRecordType { REPLAY_INPUT, REPLAY_CHECKSUM, REPLAY_END, REPLAY_STEP_INPUT } replayRecordType;
+typedef enum replayResult { REPLAY_OK, REPLAY_FINISHED, REPLAY_MISMATCH, REPLAY_BROKEN } replayResult;
+
+typedef struct replayHeader
+{
+	unsigned int version;
+	bool fixedPoint; //recorded by the fixed point build
+	unsigned int seed;
+	int level;
+	double step; //seconds simulated by every gameStep
+	int winWidth;
+	int winHeight;
+	unsigned int checksumInterval;
+} replayHeader;
+
+typedef struct replayWriter
+{
+	FILE* file;
+	long long steps; //gameStep calls recorded so far
+	long long lastRecord; //step of the last record, the next one stores the distance from it
+	int lastDir;
+	bool lastPointer;
+	double lastPointerX;
+	unsigned int checksumInterval;
+} replayWriter;
+
+typedef struct replayReader
+{
+	FILE* file;
+	long dataStart; //where the records start, after the header
+	replayHeader header;
+	long long steps;
+	long long nextRecord; //step of the record read ahead, -1 once the end was reached
+	replayRecordType nextType;
+	int nextDir;
+	gameInput nextStepInput; //the changes inside the step of a step input record
+	unsigned int nextChecksum;
+	gameInput input; //the input the player had at this step
+	long long mismatchStep; //step where the checksum was different, -1 if none
+} replayReader;
+
+/* recording: open it after gameInitLevel and call replayRecord after every gameStep with the input that was used */
+bool replayOpenWrite(replayWriter* w, const char* path, const gameState* s, double step);
+void replayRecord(replayWriter* w, const gameInput* in, const gameState* s);
+void replayCloseWrite(replayWriter* w, const gameState* s);
+
+/* playback: replayOpenRead reads the header (a replay of the other build, fixed point or not, is read but replayStep will not match), replayStart sets up the game it describes and every replayStep
+   runs one gameStep with the recorded input and checks the checksums on the way, it stops at the first one that is different */
+bool replayOpenRead(replayReader* r, const char* path);
+void replayStart(replayReader* r, gameState* s);
+replayResult replayStep(replayReader* r, gameState* s);
+void replayCloseRead(replayReader* r);
+
+#endif
@@ -0,0 +1,82 @@
+// benchmark results, see results.h
+
+#include "results.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static benchResult results[RESULTS_MAX];
+static int numberResults = 0;
+
+void resultAdd(const char* name, double value, const char* unit, bool lowerIsBetter) {
+	if (numberResults == RESULTS_MAX) return;
+	benchResult* r = &results[numberResults++];
+	snprintf(r->name, sizeof(r->name), "%s", name);
+	snprintf(r->unit, sizeof(r->unit), "%s", unit);
+	r->value = value;
+	r->lowerIsBetter = lowerIsBetter;
+}
+
+bool resultsWrite(const char* path, const char* program) {
+	FILE* f = fopen(path, "w");
+	if (f == NULL) return false;
+	fprintf(f, "{\n\t\"program\": \"%s\",\n\t\"time\": %lld,\n\t\"results\": [\n", program, (long long)time(NULL));
+	for (int i = 0; i < numberResults; i++) {
+		benchResult* r = &results[i];
+		fprintf(f, "\t\t{ \"name\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"better\": \"%s\" }%s\n", r->name, r->value, r->unit,
+			r->lowerIsBetter ? "lower" : "higher", i + 1 < numberResults ? "," : "");
+	}
+	fprintf(f, "\t]\n}\n");
+	return fclose(f) == 0;
+}
+
+static char* readFile(const char* path) {
+	FILE* f = fopen(path, "rb");
+	if (f == NULL) return NULL;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	char* text = malloc(size + 1);
+	if (text != NULL && size >= 0 && fread(text, 1, size, f) == (size_t)size) text[size] = 0;
+	else {
+		free(text);
+		text = NULL;
+	}
+	fclose(f);
+	return text;
+}
+
+/* only reads what resultsWrite writes: the value that follows "name": "...", false if the name is not there */
+static bool findValue(const char* text, const char* name, double* value) {
+	char key[96];
+	snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+	const char* at = strstr(text, key);
+	if (at == NULL) return false;
+	at = strstr(at, "\"value\":");
+	if (at == NULL) return false;
+	*value = strtod(at + 8, NULL);
+	return true;
+}
+
+int resultsCompare(const char* path, double tolerance, FILE* out) {
+	char* text = readFile(path);
+	if (text == NULL) return -1;
+	int regressions = 0;
+	fprintf(out, "\ncompared with %s (worse by more than %.0f%% is a regression)\n", path, tolerance * 100.0);
+	for (int i = 0; i < numberResults; i++) {
+		benchResult* r = &results[i];
+		double base;
+		if (!findValue(text, r->name, &base)) {
+			fprintf(out, "  %-40s %12.4g %-8s      (new)\n", r->name, r->value, r->unit);
+			continue;
+		}
+		double change = base != 0.0 ? (r->value - base) / base : 0.0;
+		double worse = r->lowerIsBetter ? change : -change;
+		bool regressed = worse > tolerance;
+		if (regressed) regressions++;
+		fprintf(out, "  %-40s %12.4g %-8s was %12.4g  %+6.1f%%%s\n", r->name, r->value, r->unit, base, change * 100.0, regressed ? "  REGRESSION" : "");
+	}
+	fprintf(out, "%d regressions\n", regressions);
+	free(text);
+	return regressions;
+}
@@ -0,0 +1,27 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+// benchmark results: every number a benchmark measures is kept with its name, so a run can be saved as JSON and
+// compared with an older one (the baseline) to catch a hot path that got slower
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define RESULTS_MAX 512
+#define RESULTS_TOLERANCE 0.15 // how much worse than the baseline a result can be before it counts as a regression
+
+typedef struct benchResult
+{
+	char name[64]; //like "grid/updateBall/4000", the same in every run
+	double value;
+	char unit[16];
+	bool lowerIsBetter; //a time, otherwise a rate
+} benchResult;
+
+void resultAdd(const char* name, double value, const char* unit, bool lowerIsBetter);
+bool resultsWrite(const char* path, const char* program); // false if the file cannot be written
+/* prints every result next to the baseline and returns how many are worse by more than tolerance (0.15 is 15%),
+   -1 if the baseline cannot be read. The results missing from the baseline are only listed */
+int resultsCompare(const char* path, double tolerance, FILE* out);
+
+#endif
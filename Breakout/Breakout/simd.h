@@ -0,0 +1,30 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// what the SIMD code needs from the compiler, for every file that has some: SIMD_X86 when the x86 intrinsics are there,
+// and the attributes that let a single function use SSE2 or AVX2 while the rest of the file is built for the plain target.
+// SIMD_INLINE makes a loop written once get inlined into both a plain and a TARGET_AVX2 function, each vectorized for its target
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define TARGET_AVX2
+#define TARGET_SSE2
+#define SIMD_INLINE __forceinline
+#else
+#define TARGET_AVX2
+#define TARGET_SSE2
+#define SIMD_INLINE inline
+#endif
+
+#endif
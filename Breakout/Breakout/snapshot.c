@@ -0,0 +1,266 @@
+// snapshots of the game state, see snapshot.h for the layout
+
+#include "snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_MAGIC 0x4e534b42u //"BKSN"
+#define SNAPSHOT_DELTA 1u
+#define SNAPSHOT_WIDE 2u //the strengths take two bytes
+#define SNAPSHOT_DELTA_PAGES_MIN 8 //blocks this small are saved whole, the page bits would cost about as much as they save
+
+typedef struct snapshotHeader
+{
+	unsigned int magic;
+	unsigned int flags;
+	int serial; //every full snapshot gets a new one, a delta keeps the one of its base to check it gets the right one back
+	int numberBlocks;
+	int numberBalls;
+	int numberPowerups;
+	int blockBytes; //size of the blocks part when it is complete
+	gameStatus status;
+	paddle paddle;
+	unsigned long long rng;
+	int score;
+} snapshotHeader;
+
+static void reserveBytes(gameSnapshot* snap, size_t size) {
+	if (size > snap->capacity) {
+		snap->capacity = size + size / 4;
+		snap->data = realloc(snap->data, snap->capacity);
+	}
+}
+
+static volatile int lastSerial = 0; //bots save from many threads
+
+static bool wideStrengths(const blockField* f) {
+	for (int i = 0; i < f->count; i++) if (f->strength[i] > 255.0f) return true;
+	return false;
+}
+
+static int blockBytes(const blockField* f, bool wide) {
+	return f->count * (wide ? 2 : 1) + (f->count + 31) / 32 * (int)sizeof(unsigned int) + f->count;
+}
+
+bool snapshotSave(gameSnapshot* snap, const gameState* s) {
+	if (s->stream != NULL) return false;
+	const blockField* f = &s->blocks;
+	bool wide = wideStrengths(f);
+	size_t balls = s->numberBalls * sizeof(ball), powerups = s->numberPowerups * sizeof(powerup);
+	int blocks = blockBytes(f, wide);
+	reserveBytes(snap, sizeof(snapshotHeader) + balls + powerups + blocks);
+
+	snapshotHeader h;
+	memset(&h, 0, sizeof(h)); //the padding too, so equal games give equal bytes
+	h.magic = SNAPSHOT_MAGIC;
+	h.flags = wide ? SNAPSHOT_WIDE : 0;
+	h.numberBlocks = f->count;
+	h.numberBalls = s->numberBalls;
+	h.numberPowerups = s->numberPowerups;
+	h.blockBytes = blocks;
+	h.status = s->status;
+	h.paddle = s->paddle;
+	h.rng = s->rng;
+	h.score = s->score;
+
+	unsigned char* p = snap->data + sizeof(h);
+	memcpy(p, s->balls, balls);
+	p += balls;
+	memcpy(p, s->powerups, powerups);
+	p += powerups;
+	if (wide) {
+		for (int i = 0; i < f->count; i++) {
+			unsigned short v = (unsigned short)f->strength[i];
+			memcpy(p + 2 * i, &v, 2);
+		}
+		p += 2 * f->count;
+	}
+	else {
+		for (int i = 0; i < f->count; i++) p[i] = (unsigned char)f->strength[i];
+		p += f->count;
+	}
+	memcpy(p, f->alive, (f->count + 31) / 32 * sizeof(unsigned int));
+	p += (f->count + 31) / 32 * sizeof(unsigned int);
+	memcpy(p, s->blockPowerups, f->count);
+	h.serial = atomicAdd(&lastSerial, 1) + 1;
+	memcpy(snap->data, &h, sizeof(h));
+	snap->size = sizeof(h) + balls + powerups + blocks;
+	return true;
+}
+
+bool snapshotSaveDelta(gameSnapshot* snap, const gameState* s, const gameSnapshot* base) {
+	snapshotHeader bh;
+	if (base == NULL || base->size < sizeof(bh) || snapshotIsDelta(base)) return false;
+	memcpy(&bh, base->data, sizeof(bh));
+	if (!snapshotSave(snap, s)) return false;
+	snapshotHeader h;
+	memcpy(&h, snap->data, sizeof(h));
+	if (h.numberBlocks != bh.numberBlocks || (h.flags & SNAPSHOT_WIDE) != (bh.flags & SNAPSHOT_WIDE)) return false;
+
+	/* the pages that are the same as in the base are left out, the ones kept move down over them.
+	   A bit for every page says which ones are there, it goes at the end. A small field stays a full snapshot,
+	   and so does one where the delta would not be smaller */
+	int numberPages = (h.blockBytes + SNAPSHOT_PAGE - 1) / SNAPSHOT_PAGE, words = (numberPages + 31) / 32;
+	if (numberPages <= SNAPSHOT_DELTA_PAGES_MIN) return true;
+	if (words > snap->capacityPages) {
+		snap->capacityPages = words;
+		snap->pages = realloc(snap->pages, words * sizeof(unsigned int));
+	}
+	memset(snap->pages, 0, words * sizeof(unsigned int));
+	size_t start = snap->size - h.blockBytes;
+	const unsigned char* old = base->data + base->size - bh.blockBytes;
+	unsigned char* blocks = snap->data + start;
+	int kept = 0;
+	for (int page = 0; page < numberPages; page++) {
+		int offset = page * SNAPSHOT_PAGE, length = h.blockBytes - offset < SNAPSHOT_PAGE ? h.blockBytes - offset : SNAPSHOT_PAGE;
+		if (memcmp(blocks + offset, old + offset, length) == 0) continue;
+		kept++;
+		snap->pages[page >> 5] |= 1u << (page & 31);
+	}
+	size_t keptBytes = kept == 0 ? 0 : (size_t)(kept - 1) * SNAPSHOT_PAGE + (snap->pages[(numberPages - 1) >> 5] >> ((numberPages - 1) & 31) & 1u ?
+		(size_t)(h.blockBytes - (numberPages - 1) * SNAPSHOT_PAGE) : SNAPSHOT_PAGE); //only the last page can be short
+	if (keptBytes + words * sizeof(unsigned int) >= (size_t)h.blockBytes) return true;
+	for (int page = 0, moved = 0; moved < kept; page++) {
+		if (!(snap->pages[page >> 5] >> (page & 31) & 1u)) continue;
+		int offset = page * SNAPSHOT_PAGE, length = h.blockBytes - offset < SNAPSHOT_PAGE ? h.blockBytes - offset : SNAPSHOT_PAGE;
+		if (moved != page) memmove(blocks + moved * SNAPSHOT_PAGE, blocks + offset, length);
+		moved++;
+	}
+	snap->size = start + keptBytes + words * sizeof(unsigned int);
+	reserveBytes(snap, snap->size);
+	memcpy(snap->data + start + keptBytes, snap->pages, words * sizeof(unsigned int));
+	h.flags |= SNAPSHOT_DELTA;
+	h.serial = bh.serial;
+	memcpy(snap->data, &h, sizeof(h));
+	return true;
+}
+
+bool snapshotIsDelta(const gameSnapshot* snap) {
+	snapshotHeader h;
+	if (snap->size < sizeof(h)) return false;
+	memcpy(&h, snap->data, sizeof(h));
+	return (h.flags & SNAPSHOT_DELTA) != 0;
+}
+
+typedef struct blockSource //the blocks of a snapshot, with the pages of the base filled in for a delta
+{
+	const unsigned char* blocks;
+	const unsigned char* base; //NULL for a full snapshot
+	const unsigned char* pages; //the bit of every page, not aligned
+	int page; //the pages are read in order, so where the next one is in blocks is counted as they go by
+	int kept; //pages of the delta before that one
+} blockSource;
+
+static bool pageKept(const blockSource* src, int page) {
+	unsigned int bits;
+	memcpy(&bits, src->pages + (page >> 5) * sizeof(unsigned int), sizeof(bits));
+	return bits >> (page & 31) & 1u;
+}
+
+static void readBlocks(blockSource* src, int offset, int length, unsigned char* out) {
+	if (src->base == NULL) {
+		memcpy(out, src->blocks + offset, length);
+		return;
+	}
+	while (length > 0) {
+		int page = offset / SNAPSHOT_PAGE, inPage = offset % SNAPSHOT_PAGE;
+		for (; src->page < page; src->page++) if (pageKept(src, src->page)) src->kept++;
+		bool kept = pageKept(src, page);
+		int n = SNAPSHOT_PAGE - inPage, last = page;
+		while (n < length && pageKept(src, last + 1) == kept) { //the next pages come from the same place, one copy does them all
+			n += SNAPSHOT_PAGE;
+			last++;
+		}
+		if (n > length) n = length;
+		if (kept) memcpy(out, src->blocks + src->kept * SNAPSHOT_PAGE + inPage, n);
+		else memcpy(out, src->base + offset, n);
+		offset += n;
+		out += n;
+		length -= n;
+	}
+}
+
+bool snapshotRestore(gameState* s, const gameSnapshot* snap, const gameSnapshot* base) {
+	snapshotHeader h, bh;
+	if (snap->size < sizeof(h) || s->stream != NULL) return false;
+	memcpy(&h, snap->data, sizeof(h));
+	blockField* f = &s->blocks;
+	if (h.magic != SNAPSHOT_MAGIC || h.numberBlocks != f->count || h.numberPowerups > s->capacityPowerups || !gameReserveBalls(s, h.numberBalls)) return false;
+
+	const unsigned char* p = snap->data + sizeof(h);
+	blockSource src = { p + h.numberBalls * sizeof(ball) + h.numberPowerups * sizeof(powerup), NULL, NULL, 0, 0 };
+	if (h.flags & SNAPSHOT_DELTA) {
+		if (base == NULL || base->size < sizeof(bh)) return false;
+		memcpy(&bh, base->data, sizeof(bh));
+		if (bh.serial != h.serial || bh.blockBytes != h.blockBytes) return false;
+		src.base = base->data + base->size - bh.blockBytes;
+		src.pages = snap->data + snap->size - ((h.blockBytes + SNAPSHOT_PAGE - 1) / SNAPSHOT_PAGE + 31) / 32 * sizeof(unsigned int);
+	}
+
+	s->paddle = h.paddle;
+	s->rng = h.rng;
+	s->score = h.score;
+	s->status = h.status;
+	s->numberBalls = h.numberBalls;
+	memcpy(s->balls, p, h.numberBalls * sizeof(ball));
+	p += h.numberBalls * sizeof(ball);
+	s->numberPowerups = h.numberPowerups;
+	memcpy(s->powerups, p, h.numberPowerups * sizeof(powerup));
+
+	/* the blocks go through a small buffer, so a delta is merged with its base on the way */
+	unsigned int words[SNAPSHOT_PAGE];
+	unsigned char* buffer = (unsigned char*)words;
+	int offset = 0, strengthBytes = (h.flags & SNAPSHOT_WIDE) ? 2 : 1;
+	for (int i = 0; i < f->count; ) {
+		int n = f->count - i < SNAPSHOT_PAGE * 2 ? f->count - i : SNAPSHOT_PAGE * 2;
+		readBlocks(&src, offset, n * strengthBytes, buffer);
+		for (int k = 0; k < n; k++) {
+			if (strengthBytes == 2) {
+				unsigned short v;
+				memcpy(&v, buffer + 2 * k, 2);
+				f->strength[i + k] = v;
+			}
+			else f->strength[i + k] = buffer[k];
+		}
+		offset += n * strengthBytes;
+		i += n;
+	}
+	/* only the blocks that came back or went away touch the grid */
+	int numberWords = (f->count + 31) / 32;
+	for (int w = 0; w < numberWords; ) {
+		int n = numberWords - w < SNAPSHOT_PAGE ? numberWords - w : SNAPSHOT_PAGE;
+		unsigned int* alive = words;
+		readBlocks(&src, offset, n * (int)sizeof(unsigned int), buffer);
+		for (int k = 0; k < n; k++, w++) {
+			unsigned int changed = alive[k] ^ f->alive[w];
+			while (changed) {
+				int bit = 0;
+				while (!(changed >> bit & 1u)) bit++;
+				int i = w * 32 + bit;
+				changed &= changed - 1;
+				if (alive[k] >> bit & 1u) {
+					f->alive[w] |= 1u << bit;
+					f->aliveCount++;
+					gridRevive(&s->grid, f, i);
+				}
+				else {
+					blockFieldKill(f, i);
+					gridRemove(&s->grid, f, i);
+				}
+			}
+		}
+		offset += n * (int)sizeof(unsigned int);
+	}
+	readBlocks(&src, offset, f->count, s->blockPowerups);
+	s->numberChanged = BLOCKS_CHANGED_MAX + 1;
+	return true;
+}
+
+void snapshotFree(gameSnapshot* snap) {
+	free(snap->data);
+	free(snap->pages);
+	snap->data = NULL;
+	snap->pages = NULL;
+	snap->size = snap->capacity = 0;
+	snap->capacityPages = 0;
+}
@@ -0,0 +1,39 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// snapshots of a game while it is played, to go back to it later: rollback, bots trying moves ahead, retry from here.
+// A snapshot is one block of bytes with no pointers in it, so it can be copied, kept in a ring or sent to another
+// process as it is (on the same kind of machine, the numbers are stored as they are in memory):
+//   - a header with the paddle, the counters, the status and the random state
+//   - the balls and the falling powerups, exactly, so the game goes on the same after a restore
+//   - the blocks: the strengths in one byte each (two if a level needs more), the alive bits and the powerups they hold
+// a delta snapshot only keeps the 64 byte pages of the blocks that are different from a base snapshot, so a bot
+// that branches a big level many times stores only what the branches changed
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "game.h"
+
+#define SNAPSHOT_PAGE 64
+
+typedef struct gameSnapshot
+{
+	unsigned char* data; //the snapshot itself
+	size_t size;
+	size_t capacity; //the memory is kept, saving again in the same snapshot does not allocate
+	unsigned int* pages; //scratch for the delta
+	int capacityPages;
+} gameSnapshot;
+
+// false for a streamed level, its chunks are not in the snapshot
+bool snapshotSave(gameSnapshot* snap, const gameState* s);
+/* base has to be a full snapshot of the same level, and it must be given again to restore. The snapshot stays a
+   full one when the blocks fit in a few pages or the delta would not be smaller, snapshotIsDelta tells which */
+bool snapshotSaveDelta(gameSnapshot* snap, const gameState* s, const gameSnapshot* base);
+/* puts the game back as it was when the snapshot was taken, base is NULL unless it is a delta. The level has to be
+   the same one (it is not in the snapshot), false if it does not match. The renderer draws all the blocks again */
+bool snapshotRestore(gameState* s, const gameSnapshot* snap, const gameSnapshot* base);
+bool snapshotIsDelta(const gameSnapshot* snap);
+void snapshotFree(gameSnapshot* snap);
+
+#endif
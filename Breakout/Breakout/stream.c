@@ -0,0 +1,215 @@
+// streamed levels: the chunk generator, its worker thread and the chunks going in and out of the game
+
+#include "stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+void streamDefaults(streamSettings* settings) {
+	settings->seed = 1;
+	settings->chunks = 16;
+	settings->columns = 16;
+	settings->blockHeight = 12.0;
+	settings->spacing = 4.0;
+	settings->density = 0.7;
+	settings->powerupChance = 0.01;
+	settings->scrollSpeed = 12.0;
+}
+
+double streamChunkBottom(int index) {
+	return STREAM_START + index * STREAM_CHUNK_HEIGHT;
+}
+
+static void makeChunk(levelStream* st, levelChunk* c, int index) { //only depends on the seed and the index, not on when it is made
+	const streamSettings* set = &st->settings;
+	unsigned long long rng;
+	randomSeed(&rng, set->seed * 2654435761u + (unsigned int)index);
+	double pitch = set->blockHeight + set->spacing;
+	double blockWidth = (st->winWidth - set->spacing * (set->columns + 1)) / set->columns;
+	int hardest = 1 + index / 4 < 5 ? 1 + index / 4 : 5; //the higher, the stronger the blocks get
+	unsigned int density = (unsigned int)(set->density * 4294967295.0), chance = (unsigned int)(set->powerupChance * 4294967295.0);
+	int n = 0;
+
+	blockFieldResize(&c->blocks, st->chunkCapacity, NULL);
+	for (int r = 0; r < st->rowsPerChunk; r++) {
+		int pattern = randomRange(&rng, 3); //0 scattered, 1 checkered, 2 a solid row with one gap
+		int gap = randomRange(&rng, set->columns);
+		for (int col = 0; col < set->columns; col++) {
+			bool place = pattern == 0 ? randomNext(&rng) <= density : pattern == 1 ? (col + r) % 2 == 0 : col != gap;
+			if (!place) continue;
+			double x = -st->winWidth / 2.0 + set->spacing * (col + 1) + blockWidth * (col + 0.5);
+			double y = streamChunkBottom(index) + pitch * (r + 0.5);
+			blockFieldSet(&c->blocks, n, x, y, blockWidth, set->blockHeight, 1 + randomRange(&rng, hardest));
+			c->powerups[n] = randomNext(&rng) < chance ? (unsigned char)(1 + randomRange(&rng, POWERUP_TYPES)) : 0;
+			n++;
+		}
+	}
+	c->blocks.count = n;
+	gridBuildArea(&c->grid, &c->blocks, -st->winWidth / 2.0, streamChunkBottom(index), st->cellSize, st->gridColumns, st->gridRows);
+	c->index = index;
+}
+
+static int streamWorker(void* data) {
+	levelStream* st = data;
+	for (;;) {
+		mutexLock(&st->lock);
+		while (!st->quit && (st->numberMade - st->numberTaken >= STREAM_AHEAD || (st->settings.chunks > 0 && st->numberMade >= st->settings.chunks))) {
+			conditionWait(&st->changed, &st->lock);
+		}
+		bool quit = st->quit;
+		int index = st->numberMade;
+		mutexUnlock(&st->lock);
+		if (quit) return 0;
+
+		PROFILE_BEGIN(zone, "make chunk");
+		makeChunk(st, &st->made[index % STREAM_AHEAD], index); //the game does not look at this one until numberMade says so
+		PROFILE_END(zone);
+
+		mutexLock(&st->lock);
+		st->numberMade++;
+		conditionBroadcast(&st->changed);
+		mutexUnlock(&st->lock);
+	}
+}
+
+static levelStream* streamCreate(const streamSettings* settings, int winWidth) {
+	levelStream* st = calloc(1, sizeof(levelStream));
+	st->settings = *settings;
+	if (st->settings.columns < 1) st->settings.columns = 1;
+	if (st->settings.blockHeight < 1.0) st->settings.blockHeight = 1.0;
+	if (st->settings.spacing < 0.0) st->settings.spacing = 0.0;
+	st->winWidth = winWidth;
+	st->rowsPerChunk = (int)(STREAM_CHUNK_HEIGHT / (st->settings.blockHeight + st->settings.spacing));
+	if (st->rowsPerChunk < 1) st->rowsPerChunk = 1;
+	st->chunkCapacity = st->settings.columns * st->rowsPerChunk;
+	double blockWidth = (winWidth - st->settings.spacing * (st->settings.columns + 1)) / st->settings.columns;
+	double target = fmax(blockWidth, st->settings.blockHeight + st->settings.spacing); //about one block per cell
+	st->gridRows = (int)(STREAM_CHUNK_HEIGHT / target);
+	if (st->gridRows < 1) st->gridRows = 1;
+	st->cellSize = STREAM_CHUNK_HEIGHT / st->gridRows; //a whole number of rows per chunk, so the grids stack
+	st->gridColumns = (int)ceil(winWidth / st->cellSize);
+	for (int i = 0; i < STREAM_AHEAD; i++) st->made[i].powerups = malloc(st->chunkCapacity);
+	for (int i = 0; i < STREAM_SLOTS; i++) st->slotChunk[i] = -1;
+	mutexInit(&st->lock);
+	conditionInit(&st->changed);
+	st->running = threadCreate(&st->worker, streamWorker, st);
+	return st;
+}
+
+void streamDestroy(levelStream* st) {
+	if (st == NULL) return;
+	mutexLock(&st->lock);
+	st->quit = true;
+	conditionBroadcast(&st->changed);
+	mutexUnlock(&st->lock);
+	if (st->running) threadJoin(st->worker);
+	for (int i = 0; i < STREAM_AHEAD; i++) {
+		blockFieldFree(&st->made[i].blocks);
+		gridFree(&st->made[i].grid);
+		free(st->made[i].powerups);
+	}
+	conditionDestroy(&st->changed);
+	mutexDestroy(&st->lock);
+	free(st);
+}
+
+bool streamFinished(const levelStream* st) {
+	return st->settings.chunks > 0 && st->numberLoaded >= st->settings.chunks;
+}
+
+static void loadChunk(gameState* s, levelStream* st) {
+	int index = st->numberLoaded;
+	mutexLock(&st->lock);
+	while (st->numberMade <= index) { //normally it is made already, if not the game waits: the level must not depend on timing
+		if (st->running) conditionWait(&st->changed, &st->lock);
+		else { //no worker thread, make it here
+			makeChunk(st, &st->made[st->numberMade % STREAM_AHEAD], st->numberMade);
+			st->numberMade++;
+		}
+	}
+	mutexUnlock(&st->lock);
+
+	const levelChunk* c = &st->made[index % STREAM_AHEAD];
+	int slot = index % STREAM_SLOTS, base = slot * st->chunkCapacity;
+	for (int k = 0; k < c->blocks.count; k++) { //the slot's old blocks are all dead, they were passed
+		blockFieldSet(&s->blocks, base + k, c->blocks.x[k], c->blocks.y[k], 2.0 * c->blocks.halfWidth[k], 2.0 * c->blocks.halfHeight[k], (int)c->blocks.strength[k]);
+	}
+	memcpy(s->blockPowerups + base, c->powerups, c->blocks.count);
+	gridAppendRows(&s->grid, &c->grid, base);
+	st->slotChunk[slot] = index;
+	st->slotCount[slot] = c->blocks.count;
+	st->slotPassed[slot] = 0;
+	st->numberLoaded++;
+
+	mutexLock(&st->lock);
+	st->numberTaken++; //the worker can reuse the chunk
+	conditionBroadcast(&st->changed);
+	mutexUnlock(&st->lock);
+}
+
+void streamStep(gameState* s, double dt) {
+	levelStream* st = s->stream;
+#ifdef GAME_FIXED
+	s->cameraY = FROM_FIXED(TO_FIXED(s->cameraY) + FIXED_MUL(TO_FIXED(st->settings.scrollSpeed), TO_FIXED(dt)));
+#else
+	s->cameraY += st->settings.scrollSpeed * dt;
+#endif
+	if (st->settings.chunks > 0) { //the window stops at the top of the level
+		double last = streamChunkBottom(st->settings.chunks) + 16.0 - s->winHeight / 2;
+		if (s->cameraY > last) s->cameraY = fmax(last, 0.0);
+	}
+	double rise = s->cameraY - 200.0 - s->paddle.y;
+	s->paddle.y += rise;
+	for (int i = 0; i < s->numberBalls && rise > 0.0; i++) { //the ball sweep only sees the ball moving, so a ball the paddle rose into is pushed on top of it
+		ball* b = &s->balls[i];
+		double top = s->paddle.y + s->paddle.height / 2.0 + b->radius;
+		if (fabs(b->x - s->paddle.x) <= s->paddle.width / 2.0 + b->radius && b->y < top && b->y > top - rise - 1e-9) b->y = top;
+	}
+
+	/* blocks going below the pass line are removed without a powerup, the chunks are sorted from the bottom so it stops at the first one above */
+	double line = s->paddle.y + STREAM_PASS_LINE;
+	for (int i = st->firstLoaded; i < st->numberLoaded && streamChunkBottom(i) < line; i++) {
+		int slot = i % STREAM_SLOTS, base = slot * st->chunkCapacity;
+		while (st->slotPassed[slot] < st->slotCount[slot]) {
+			int index = base + st->slotPassed[slot];
+			if (s->blocks.y[index] - s->blocks.halfHeight[index] >= line) break;
+			if (BLOCK_ALIVE(&s->blocks, index)) {
+				blockFieldKill(&s->blocks, index);
+				gridRemove(&s->grid, &s->blocks, index);
+				gameBlockChanged(s, index);
+			}
+			st->slotPassed[slot]++;
+		}
+	}
+	while (st->firstLoaded < st->numberLoaded) { //drop the chunks that went by
+		int slot = st->firstLoaded % STREAM_SLOTS;
+		if (st->slotPassed[slot] < st->slotCount[slot] || streamChunkBottom(st->firstLoaded + 1) >= line) break;
+		gridDropRows(&s->grid, st->gridRows);
+		st->firstLoaded++;
+	}
+
+	/* load the chunks coming into view, one chunk early */
+	double top = s->cameraY + s->winHeight / 2 + STREAM_CHUNK_HEIGHT;
+	while ((st->settings.chunks == 0 || st->numberLoaded < st->settings.chunks) && st->numberLoaded - st->firstLoaded < STREAM_SLOTS &&
+		streamChunkBottom(st->numberLoaded) < top) {
+		loadChunk(s, st);
+	}
+}
+
+void gameInitStream(gameState* s, const streamSettings* settings, int winWidth, int winHeight) {
+	levelStream* st = streamCreate(settings, winWidth);
+	int slotsBlocks = STREAM_SLOTS * st->chunkCapacity;
+	int powerups = (int)(slotsBlocks * st->settings.powerupChance * 2.0) + 8; //room for more than are usually falling, the others are lost
+	if (!gameReserve(s, slotsBlocks, powerups, false)) { //this stops the stream of the last level
+		streamDestroy(st);
+		return;
+	}
+	s->stream = st;
+	randomSeed(&s->rng, st->settings.seed);
+	s->seed = st->settings.seed;
+	s->level = 0;
+	blockFieldResize(&s->blocks, slotsBlocks, &s->arena);
+	gridFree(&s->grid); //the grid of every chunk is added on top
+	gameStart(s, winWidth, winHeight);
+	streamStep(s, 0.0);
+}
@@ -0,0 +1,73 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+// streamed levels: procedural levels much taller than the window, which scrolls up through them. The blocks are made
+// in chunks of STREAM_CHUNK_HEIGHT pixels, each with its own grid, by a worker thread that stays a few chunks ahead.
+// The game only holds the chunks around the window and drops a chunk once all its blocks went below the paddle,
+// so the memory used does not depend on how long the level is (it can even never end)
+
+#include <stdbool.h>
+#include "game.h"
+
+#define STREAM_CHUNK_HEIGHT 256.0
+#define STREAM_START 40.0 // bottom of the first chunk, the ball starts under it
+#define STREAM_SLOTS 6 // chunks loaded in the game at the same time
+#define STREAM_AHEAD 4 // chunks the worker makes before the game needs them
+#define STREAM_PASS_LINE 160.0 // blocks scrolling lower than this above the paddle are passed and removed, so the player has time to react
+
+typedef struct streamSettings
+{
+	unsigned int seed; //the same seed always gives the same level
+	int chunks; //length of the level, 0 never ends
+	int columns; //blocks per row
+	double blockHeight;
+	double spacing;
+	double density; //share of the places that get a block, from 0 to 1
+	double powerupChance; //of every block
+	double scrollSpeed; //pixels per second the window moves up
+} streamSettings;
+
+typedef struct levelChunk
+{
+	int index; //chunk number from the bottom of the level
+	blockField blocks; //in level coordinates, from the bottom row up
+	blockGrid grid; //over the chunk only, the same layout for every chunk so the grids can be stacked
+	unsigned char* powerups; //like gameState.blockPowerups
+} levelChunk;
+
+typedef struct levelStream
+{
+	streamSettings settings;
+	int winWidth;
+	int rowsPerChunk;
+	int chunkCapacity; //most blocks a chunk can have
+	double cellSize; //of the chunk grids
+	int gridColumns;
+	int gridRows;
+	/* the worker side, chunk i waits in made[i % STREAM_AHEAD] until the game takes it */
+	levelChunk made[STREAM_AHEAD];
+	int numberMade;
+	int numberTaken;
+	mutex lock;
+	condition changed;
+	thread worker;
+	bool running; //false if the thread could not be started, then the game makes the chunks itself
+	bool quit;
+	/* the game side, chunk i is loaded in slot i % STREAM_SLOTS: the blocks from slot * chunkCapacity on in gameState.blocks */
+	int slotChunk[STREAM_SLOTS]; //-1 for a slot that was never used
+	int slotCount[STREAM_SLOTS]; //blocks of the chunk in the slot
+	int slotPassed[STREAM_SLOTS]; //how many of them went below the pass line
+	int firstLoaded; //the chunks from firstLoaded to numberLoaded-1 are in the game, and in its grid in that order
+	int numberLoaded;
+} levelStream;
+
+void streamDefaults(streamSettings* settings);
+double streamChunkBottom(int index); // where the chunk starts in the level
+bool streamFinished(const levelStream* st); // all the chunks of a level that ends are loaded
+void streamDestroy(levelStream* st); // stops the worker, gameReserve and gameFree call it for the stream of the game
+// like gameInitLevel, for a streamed level. The first chunks are made before it returns, the next ones while playing
+void gameInitStream(gameState* s, const streamSettings* settings, int winWidth, int winHeight);
+// gameStep calls it first: scrolls the window, removes the passed blocks, drops old chunks and loads the ones coming into view
+void streamStep(gameState* s, double dt);
+
+#endif
@@ -0,0 +1,138 @@
+// the HUD text, see text.h
+
+#include "text.h"
+#include <string.h>
+#include "profile.h"
+
+/* 5 by 7 pixels, 5 columns per character from left to right, the lowest bit at the top */
+static const unsigned char font[64][TEXT_GLYPH_WIDTH] = {
+	{0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14}, // space ! " #
+	{0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00}, // $ % & '
+	{0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08}, // ( ) * +
+	{0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02}, // , - . /
+	{0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31}, // 0 1 2 3
+	{0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03}, // 4 5 6 7
+	{0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00}, // 8 9 : ;
+	{0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06}, // < = > ?
+	{0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22}, // @ A B C
+	{0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x01,0x01}, {0x3E,0x41,0x41,0x51,0x32}, // D E F G
+	{0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41}, // H I J K
+	{0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x04,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E}, // L M N O
+	{0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31}, // P Q R S
+	{0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x7F,0x20,0x18,0x20,0x7F}, // T U V W
+	{0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00}, // X Y Z [
+	{0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40}  // \ ] ^ _
+};
+
+void textInit(textLayer* t) {
+	memset(t, 0, sizeof(*t));
+	static unsigned char pixels[TEXT_ATLAS_HEIGHT][TEXT_ATLAS_WIDTH]; //only alpha, the colour comes from the vertices
+	memset(pixels, 0, sizeof(pixels));
+	for (int g = 0; g < 64; g++) {
+		int left = g % 16 * 8, top = g / 16 * 8;
+		for (int x = 0; x < TEXT_GLYPH_WIDTH; x++) {
+			for (int y = 0; y < TEXT_GLYPH_HEIGHT; y++) if (font[g][x] >> y & 1) pixels[top + y][left + x] = 255;
+		}
+	}
+	glGenTextures(1, &t->atlas);
+	glBindTexture(GL_TEXTURE_2D, t->atlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, TEXT_ATLAS_WIDTH, TEXT_ATLAS_HEIGHT, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); //whole pixels of the font, no blur
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void textFree(textLayer* t) {
+	if (t->atlas != 0) glDeleteTextures(1, &t->atlas);
+	t->atlas = 0;
+}
+
+static void layout(textLayer* t, int id) {
+	textString* s = &t->strings[id];
+	textVertex* v = t->vertices + id * TEXT_LENGTH_MAX * 4;
+	memset(v, 0, TEXT_LENGTH_MAX * 4 * sizeof(textVertex)); //the characters it does not use have no size
+	if (!s->used) return;
+	for (int i = 0; s->text[i] != '\0'; i++, v += 4) {
+		int c = s->text[i];
+		if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+		if (c < ' ' || c > '_') c = '?';
+		int g = c - ' ';
+		float u0 = (float)(g % 16 * 8) / TEXT_ATLAS_WIDTH, v0 = (float)(g / 16 * 8) / TEXT_ATLAS_HEIGHT;
+		float u1 = u0 + (float)TEXT_GLYPH_WIDTH / TEXT_ATLAS_WIDTH, v1 = v0 + (float)TEXT_GLYPH_HEIGHT / TEXT_ATLAS_HEIGHT;
+		float x0 = s->x + i * (TEXT_GLYPH_WIDTH + 1) * s->scale, x1 = x0 + TEXT_GLYPH_WIDTH * s->scale;
+		float y0 = s->y, y1 = s->y - TEXT_GLYPH_HEIGHT * s->scale;
+		const float corners[4][4] = { { x0, y0, u0, v0 }, { x1, y0, u1, v0 }, { x1, y1, u1, v1 }, { x0, y1, u0, v1 } }; //clockwise from the top left
+		for (int k = 0; k < 4; k++) {
+			v[k].x = corners[k][0];
+			v[k].y = corners[k][1];
+			v[k].u = corners[k][2];
+			v[k].v = corners[k][3];
+			memcpy(v[k].colour, s->colour, 4);
+		}
+	}
+}
+
+static void updateCount(textLayer* t) {
+	int last = -1;
+	for (int i = 0; i < TEXT_STRINGS_MAX; i++) if (t->strings[i].used) last = i;
+	t->numberVertices = (last + 1) * TEXT_LENGTH_MAX * 4;
+}
+
+void textSet(textLayer* t, int id, const char* text, float x, float y, float scale, const GLubyte colour[4]) {
+	if (id < 0 || id >= TEXT_STRINGS_MAX) return;
+	textString* s = &t->strings[id];
+	if (s->used && s->x == x && s->y == y && s->scale == scale && memcmp(s->colour, colour, 4) == 0 && strncmp(s->text, text, TEXT_LENGTH_MAX) == 0) return;
+	strncpy(s->text, text, TEXT_LENGTH_MAX);
+	s->text[TEXT_LENGTH_MAX] = '\0';
+	s->x = x;
+	s->y = y;
+	s->scale = scale;
+	memcpy(s->colour, colour, 4);
+	s->used = true;
+	layout(t, id);
+	updateCount(t);
+	t->rebuilt++;
+	t->totalRebuilt++;
+}
+
+void textClear(textLayer* t, int id) {
+	if (id < 0 || id >= TEXT_STRINGS_MAX || !t->strings[id].used) return;
+	t->strings[id].used = false;
+	layout(t, id);
+	updateCount(t);
+}
+
+float textWidth(const char* text, float scale) {
+	size_t n = strlen(text);
+	if (n > TEXT_LENGTH_MAX) n = TEXT_LENGTH_MAX;
+	return n > 0 ? (n * (TEXT_GLYPH_WIDTH + 1) - 1) * scale : 0.0f;
+}
+
+bool textDraw(textLayer* t) {
+	t->rebuilt = 0;
+	if (t->numberVertices == 0 || t->atlas == 0) return false;
+	PROFILE_BEGIN(zone, "text");
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, t->atlas);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE); //the colour of the vertex, the alpha of the atlas
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(textVertex), &t->vertices[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(textVertex), &t->vertices[0].u);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(textVertex), t->vertices[0].colour);
+	glDrawArrays(GL_QUADS, 0, t->numberVertices);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	PROFILE_END(zone);
+	return true;
+}
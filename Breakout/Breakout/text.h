@@ -0,0 +1,59 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+// text for the HUD. The glyphs of a small bitmap font are drawn once into an atlas texture, every string has its own part
+// of one vertex array and is laid out again only when it changes, and all the strings are drawn with a single call.
+// The font is built in: the menu font (ethnocentric rg.otf) would need a TrueType rasterizer the game does not have.
+// It has the characters from space to _, lower case letters are shown in upper case and the others as ?
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <stdbool.h>
+
+#define TEXT_STRINGS_MAX 8
+#define TEXT_LENGTH_MAX 48 // characters of a string, the rest is cut
+#define TEXT_ATLAS_WIDTH 128 // 16 by 4 cells of 8 pixels, a power of two for GL 1.1
+#define TEXT_ATLAS_HEIGHT 32
+#define TEXT_GLYPH_WIDTH 5 // pixels of the font, a character takes one more for the gap
+#define TEXT_GLYPH_HEIGHT 7
+
+typedef struct textVertex
+{
+	GLfloat x;
+	GLfloat y;
+	GLfloat u;
+	GLfloat v;
+	GLubyte colour[4];
+} textVertex;
+
+typedef struct textString
+{
+	char text[TEXT_LENGTH_MAX + 1];
+	float x; //top left corner, in the coordinates of the window (0, 0 in the centre)
+	float y;
+	float scale; //pixels of the window for one pixel of the font
+	GLubyte colour[4];
+	bool used;
+} textString;
+
+typedef struct textLayer
+{
+	GLuint atlas;
+	textString strings[TEXT_STRINGS_MAX];
+	textVertex vertices[TEXT_STRINGS_MAX * TEXT_LENGTH_MAX * 4]; //4 per character of every string, the ones a string does not use have no size
+	int numberVertices; //up to the end of the last string used
+	int rebuilt; //strings laid out again since the last textDraw
+	long long totalRebuilt;
+} textLayer;
+
+void textInit(textLayer* t); // once there is a GL context, draws the atlas
+void textFree(textLayer* t);
+// puts text in string id, it is only laid out again if something changed
+void textSet(textLayer* t, int id, const char* text, float x, float y, float scale, const GLubyte colour[4]);
+void textClear(textLayer* t, int id);
+float textWidth(const char* text, float scale);
+bool textDraw(textLayer* t); // all the strings with one call, over the picture, false if there was nothing to draw
+
+#endif
@@ -0,0 +1,220 @@
+// threads, atomics and the work-stealing thread pool
+
+#include "thread.h"
+#include <stdlib.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+typedef struct threadStart
+{
+	threadFunction fn;
+	void* data;
+} threadStart;
+
+#ifdef _WIN32
+
+static DWORD WINAPI threadEntry(LPVOID p) {
+	threadStart start = *(threadStart*)p;
+	free(p);
+	return (DWORD)start.fn(start.data);
+}
+
+bool threadCreate(thread* t, threadFunction fn, void* data) {
+	threadStart* start = malloc(sizeof(threadStart));
+	start->fn = fn;
+	start->data = data;
+	*t = CreateThread(NULL, 0, threadEntry, start, 0, NULL);
+	if (*t == NULL) free(start);
+	return *t != NULL;
+}
+
+void threadJoin(thread t) {
+	WaitForSingleObject(t, INFINITE);
+	CloseHandle(t);
+}
+
+int threadCpuCount(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+}
+
+void mutexInit(mutex* m) { InitializeCriticalSection(m); }
+void mutexLock(mutex* m) { EnterCriticalSection(m); }
+void mutexUnlock(mutex* m) { LeaveCriticalSection(m); }
+void mutexDestroy(mutex* m) { DeleteCriticalSection(m); }
+void conditionInit(condition* c) { InitializeConditionVariable(c); }
+void conditionWait(condition* c, mutex* m) { SleepConditionVariableCS(c, m, INFINITE); }
+void conditionBroadcast(condition* c) { WakeAllConditionVariable(c); }
+void conditionDestroy(condition* c) { (void)c; }
+
+int atomicLoad(volatile int* p) { return (int)InterlockedOr((volatile LONG*)p, 0); }
+void atomicStore(volatile int* p, int v) { InterlockedExchange((volatile LONG*)p, v); }
+int atomicAdd(volatile int* p, int v) { return (int)InterlockedExchangeAdd((volatile LONG*)p, v); }
+long long atomicLoad64(volatile long long* p) { return InterlockedOr64(p, 0); }
+void atomicStore64(volatile long long* p, long long v) { InterlockedExchange64(p, v); }
+bool atomicCompareSwap64(volatile long long* p, long long expected, long long desired) {
+	return InterlockedCompareExchange64(p, desired, expected) == expected;
+}
+
+#else
+
+static void* threadEntry(void* p) {
+	threadStart start = *(threadStart*)p;
+	free(p);
+	start.fn(start.data);
+	return NULL;
+}
+
+bool threadCreate(thread* t, threadFunction fn, void* data) {
+	threadStart* start = malloc(sizeof(threadStart));
+	start->fn = fn;
+	start->data = data;
+	if (pthread_create(t, NULL, threadEntry, start) != 0) {
+		free(start);
+		return false;
+	}
+	return true;
+}
+
+void threadJoin(thread t) {
+	pthread_join(t, NULL);
+}
+
+int threadCpuCount(void) {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+}
+
+void mutexInit(mutex* m) { pthread_mutex_init(m, NULL); }
+void mutexLock(mutex* m) { pthread_mutex_lock(m); }
+void mutexUnlock(mutex* m) { pthread_mutex_unlock(m); }
+void mutexDestroy(mutex* m) { pthread_mutex_destroy(m); }
+void conditionInit(condition* c) { pthread_cond_init(c, NULL); }
+void conditionWait(condition* c, mutex* m) { pthread_cond_wait(c, m); }
+void conditionBroadcast(condition* c) { pthread_cond_broadcast(c); }
+void conditionDestroy(condition* c) { pthread_cond_destroy(c); }
+
+int atomicLoad(volatile int* p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+void atomicStore(volatile int* p, int v) { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+int atomicAdd(volatile int* p, int v) { return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST); }
+long long atomicLoad64(volatile long long* p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+void atomicStore64(volatile long long* p, long long v) { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+bool atomicCompareSwap64(volatile long long* p, long long expected, long long desired) {
+	return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
+/* thread pool */
+
+#define RANGE(begin, end) (((long long)(begin) << 32) | (unsigned int)(end))
+#define RANGE_BEGIN(r) ((int)((r) >> 32))
+#define RANGE_END(r) ((int)((r) & 0xffffffff))
+
+static void runJob(threadPool* pool, int w) {
+	for (;;) {
+		long long r = atomicLoad64(&pool->ranges[w]);
+		int begin = RANGE_BEGIN(r), end = RANGE_END(r);
+		if (begin < end) { //work on our own slice first
+			int take = end - begin < pool->chunk ? end - begin : pool->chunk;
+			if (atomicCompareSwap64(&pool->ranges[w], r, RANGE(begin + take, end))) pool->task(pool->data, begin, begin + take, w);
+			continue;
+		}
+
+		int victim = -1, most = 0;
+		long long victimRange = 0;
+		for (int v = 0; v < pool->numberWorkers; v++) { //the worker with the most work left
+			long long vr = atomicLoad64(&pool->ranges[v]);
+			if (RANGE_END(vr) - RANGE_BEGIN(vr) > most) {
+				most = RANGE_END(vr) - RANGE_BEGIN(vr);
+				victim = v;
+				victimRange = vr;
+			}
+		}
+		if (victim < 0) return; //nothing left anywhere, the items still running belong to other workers
+
+		int middle = RANGE_END(victimRange) - (most + 1) / 2; //steal the back half
+		if (atomicCompareSwap64(&pool->ranges[victim], victimRange, RANGE(RANGE_BEGIN(victimRange), middle))) {
+			atomicStore64(&pool->ranges[w], RANGE(middle, RANGE_END(victimRange)));
+		}
+	}
+}
+
+static int poolWorker(void* data) {
+	workerStart* start = data;
+	threadPool* pool = start->pool;
+	int seen = 0;
+	for (;;) {
+		mutexLock(&pool->lock);
+		while (pool->generation == seen && !pool->quit) conditionWait(&pool->wake, &pool->lock);
+		seen = pool->generation;
+		int quit = pool->quit;
+		mutexUnlock(&pool->lock);
+		if (quit) return 0;
+
+		runJob(pool, start->index);
+
+		mutexLock(&pool->lock);
+		if (--pool->busy == 0) conditionBroadcast(&pool->done);
+		mutexUnlock(&pool->lock);
+	}
+}
+
+threadPool* threadPoolCreate(int numberWorkers) {
+	threadPool* pool = calloc(1, sizeof(threadPool));
+	if (numberWorkers <= 0) numberWorkers = threadCpuCount();
+	if (numberWorkers > THREADS_MAX) numberWorkers = THREADS_MAX;
+	mutexInit(&pool->lock);
+	conditionInit(&pool->wake);
+	conditionInit(&pool->done);
+	pool->numberWorkers = 1;
+	for (int i = 1; i < numberWorkers; i++) {
+		workerStart* start = &pool->starts[i];
+		start->pool = pool;
+		start->index = i;
+		if (!threadCreate(&pool->threads[i], poolWorker, start)) break;
+		pool->numberWorkers++;
+	}
+	return pool;
+}
+
+void threadPoolDestroy(threadPool* pool) {
+	if (pool == NULL) return;
+	mutexLock(&pool->lock);
+	pool->quit = 1;
+	conditionBroadcast(&pool->wake);
+	mutexUnlock(&pool->lock);
+	for (int i = 1; i < pool->numberWorkers; i++) threadJoin(pool->threads[i]);
+	conditionDestroy(&pool->wake);
+	conditionDestroy(&pool->done);
+	mutexDestroy(&pool->lock);
+	free(pool);
+}
+
+void threadPoolFor(threadPool* pool, int count, int chunk, poolTask task, void* data) {
+	if (chunk < 1) chunk = 1;
+	if (pool == NULL || pool->numberWorkers == 1 || count <= chunk) { //not worth waking anyone
+		if (count > 0) task(data, 0, count, 0);
+		return;
+	}
+	pool->task = task;
+	pool->data = data;
+	pool->chunk = chunk;
+	for (int w = 0; w < pool->numberWorkers; w++) {
+		atomicStore64(&pool->ranges[w], RANGE((long long)count * w / pool->numberWorkers, (long long)count * (w + 1) / pool->numberWorkers));
+	}
+
+	mutexLock(&pool->lock);
+	pool->busy = pool->numberWorkers - 1;
+	pool->generation++;
+	conditionBroadcast(&pool->wake);
+	mutexUnlock(&pool->lock);
+
+	runJob(pool, 0);
+
+	mutexLock(&pool->lock);
+	while (pool->busy > 0) conditionWait(&pool->done, &pool->lock);
+	mutexUnlock(&pool->lock);
+}
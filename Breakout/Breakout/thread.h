@@ -0,0 +1,80 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+// threads, atomics and a work-stealing thread pool, on top of Win32 or pthreads (no SDL, so the headless tools can use it)
+
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE thread;
+typedef CRITICAL_SECTION mutex;
+typedef CONDITION_VARIABLE condition;
+#define THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+typedef pthread_t thread;
+typedef pthread_mutex_t mutex;
+typedef pthread_cond_t condition;
+#define THREAD_LOCAL __thread
+#endif
+
+#define THREADS_MAX 64
+
+typedef int (*threadFunction)(void* data);
+
+bool threadCreate(thread* t, threadFunction fn, void* data);
+void threadJoin(thread t);
+int threadCpuCount(void);
+
+void mutexInit(mutex* m);
+void mutexLock(mutex* m);
+void mutexUnlock(mutex* m);
+void mutexDestroy(mutex* m);
+void conditionInit(condition* c);
+void conditionWait(condition* c, mutex* m);
+void conditionBroadcast(condition* c);
+void conditionDestroy(condition* c);
+
+/* atomics, all of them sequentially consistent */
+int atomicLoad(volatile int* p);
+void atomicStore(volatile int* p, int v);
+int atomicAdd(volatile int* p, int v); // returns the old value
+long long atomicLoad64(volatile long long* p);
+void atomicStore64(volatile long long* p, long long v);
+bool atomicCompareSwap64(volatile long long* p, long long expected, long long desired);
+
+typedef void (*poolTask)(void* data, int begin, int end, int worker); // processes the items from begin to end-1
+
+typedef struct threadPool threadPool;
+
+typedef struct workerStart
+{
+	threadPool* pool;
+	int index;
+} workerStart;
+
+struct threadPool
+{
+	int numberWorkers; //the thread calling threadPoolFor works too, so it is worker 0
+	thread threads[THREADS_MAX];
+	workerStart starts[THREADS_MAX];
+	volatile long long ranges[THREADS_MAX]; //what is left for every worker: first item in the high half, end in the low half
+	mutex lock;
+	condition wake;
+	condition done;
+	volatile int generation; //goes up by one for every job
+	volatile int busy; //workers still running the current job
+	volatile int quit;
+	poolTask task;
+	void* data;
+	int chunk;
+};
+
+threadPool* threadPoolCreate(int numberWorkers); // 0 uses one worker per CPU
+void threadPoolDestroy(threadPool* pool);
+/* runs task over the items 0..count-1 and returns when all of them are done. Every worker starts with an
+   equal slice and takes chunk items at a time from it, a worker that runs out steals half of what is left of the busiest one */
+void threadPoolFor(threadPool* pool, int count, int chunk, poolTask task, void* data);
+
+#endif